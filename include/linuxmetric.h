@@ -29,6 +29,8 @@ extern "C" {
 #define LINUXMETRIC_UPTIME "uptime"
 #define LINUXMETRIC_CPU_USAGE "usage.cpu"
 #define LINUXMETRIC_CPU_TEMPERATURE "temperature.cpu"
+#define LINUXMETRIC_CPU_THROTTLE_COUNT "throttle_count.cpu"
+#define LINUXMETRIC_CPU_PACKAGE_THROTTLE_COUNT "package_throttle_count.cpu"
 #define LINUXMETRIC_MEMORY_TOTAL "total.memory"
 #define LINUXMETRIC_MEMORY_USED "used.memory"
 #define LINUXMETRIC_MEMORY_USAGE "usage.memory"
@@ -38,10 +40,25 @@ extern "C" {
 #define LINUXMETRIC_SYSTEM_TOTAL "total.system"
 #define LINUXMETRIC_SYSTEM_USED  "used.system"
 #define LINUXMETRIC_SYSTEM_USAGE "usage.system"
+#define LINUXMETRIC_INTERRUPTS "interrupts"
+#define LINUXMETRIC_OOM_KILL_RATE "rate.oom_kill"
+#define LINUXMETRIC_SWAP_IN_RATE "rate.pswpin"
+#define LINUXMETRIC_SWAP_OUT_RATE "rate.pswpout"
+#define LINUXMETRIC_MAJOR_FAULT_RATE "rate.pgmajfault"
+#define LINUXMETRIC_ALLOC_STALL_RATE "rate.allocstall"
 
 #define BANDWIDTH_TEMPLATE "%s_bandwidth.%s"
 #define BYTES_TEMPLATE "%s_bytes.%s"
 #define ERROR_RATIO_TEMPLATE "%s_error_ratio.%s"
+#define UTILIZATION_TEMPLATE "%s_utilization.%s"
+#define CPU_FREQUENCY_TEMPLATE "frequency.cpu.%s"
+#define SOFTIRQ_TEMPLATE "%s_softirq"
+#define CPU_RATE_TEMPLATE "%s.cpu%d"
+#define SKEW_TEMPLATE "%s_skew"
+#define WRITTEN_BYTES_TEMPLATE "written_bytes.%s"
+#define WRITE_RATE_TEMPLATE "write_rate.%s"
+#define EMMC_LIFE_TIME_TEMPLATE "emmc_life_time.%s"
+#define EMMC_PRE_EOL_TEMPLATE "emmc_pre_eol.%s"
 
 struct _linuxmetric_t {
     char *type;
@@ -58,16 +75,28 @@ FTY_INFO_EXPORT linuxmetric_t *
 FTY_INFO_EXPORT void
     linuxmetric_destroy (linuxmetric_t **self_p);
 
-// Create zlistx containing all Linux system info
+// Discover cpufreq policies and thermal throttle counters and open them.
+// Returned list is to be passed to every linuxmetric_get_all call and
+// destroyed by zlistx_destroy, which closes the files.
+FTY_INFO_EXPORT zlistx_t *
+    linuxmetric_cpu_sources_new (std::string &root_dir);
+
+// Create zlistx containing all Linux system info. Rates are computed over
+// interval, seconds elapsed since the previous call with the same history.
 FTY_INFO_EXPORT zlistx_t *
     linuxmetric_get_all
-    (int interval,
+    (double interval,
      zhashx_t *history,
+     zlistx_t *cpu_sources,
      std::string &root_dir,
      bool metrics_test);
 
 FTY_INFO_EXPORT zhashx_t *
     linuxmetric_list_interfaces (std::string &root_dir);
+
+// Create zlistx containing names of all physical block devices
+FTY_INFO_EXPORT zlistx_t *
+    linuxmetric_list_block_devices (std::string &root_dir);
 //  @end
 
 #ifdef __cplusplus
@@ -28,16 +28,8 @@
 
 #include "fty_info_classes.h"
 
-#define RC0_RUNONCE_ACTOR "fty-info-rc0-runonce"
 #define DEFAULT_LOG_CONFIG "/etc/fty/ftylog.cfg"
 
-static int
-s_linuxmetrics_event (zloop_t *loop, int timer_id, void *output)
-{
-    zstr_send (output, "LINUXMETRICS");
-    return 0;
-}
-
 void
 usage(){
     puts   ("fty-info [options] ...");
@@ -50,8 +42,11 @@ usage(){
 
 int main (int argc, char *argv [])
 {
-    int linuxmetrics_interval = DEFAULT_LINUXMETRICS_INTERVAL_SEC;
     char *str_linuxmetrics_interval = NULL;
+    char *str_announce_window = NULL;
+    const char *announce_delta = "false";
+    const char *latency_metrics = "false";
+    char *str_announce_interval = NULL;
     char *config_file = NULL;
     zconfig_t *config = NULL;
     char* actor_name = NULL;
@@ -109,9 +104,18 @@ int main (int argc, char *argv [])
 
         // Linux metrics publishing interval (in seconds)
         str_linuxmetrics_interval = strdup(s_get (config, "server/check_interval", "30"));
-        if (str_linuxmetrics_interval) {
-            linuxmetrics_interval = atoi (str_linuxmetrics_interval);
-        }
+
+        // HEARTBEAT announce interval (in seconds)
+        str_announce_interval = strdup(s_get (config, "server/announce", STR_DEFAULT_ANNOUNCE_INTERVAL_SEC));
+
+        // coalescing window of announces (in msec)
+        str_announce_window = strdup(s_get (config, "server/announce_window", STR_DEFAULT_ANNOUNCE_WINDOW_MS));
+        // publish only changed INFO keys
+        if (streq (zconfig_get (config, "server/announce_delta", "false"), "true"))
+            announce_delta = "true";
+        // publish request latencies along with Linux metrics
+        if (streq (zconfig_get (config, "server/latency_metrics", "false"), "true"))
+            latency_metrics = "true";
 
         if (endpoint) zstr_free(&endpoint);
         endpoint = strdup(s_get (config, "malamute/endpoint", NULL));
@@ -135,35 +139,42 @@ int main (int argc, char *argv [])
         path = strdup(DEFAULT_PATH);
     if (str_linuxmetrics_interval == NULL)
         str_linuxmetrics_interval = strdup(STR_DEFAULT_LINUXMETRICS_INTERVAL_SEC);
+    if (str_announce_interval == NULL)
+        str_announce_interval = strdup(STR_DEFAULT_ANNOUNCE_INTERVAL_SEC);
+    if (str_announce_window == NULL)
+        str_announce_window = strdup(STR_DEFAULT_ANNOUNCE_WINDOW_MS);
 
     zactor_t *server = zactor_new (fty_info_server, (void*) actor_name);
 
     //  Insert main code here
     zstr_sendx (server, "PATH", path, NULL);
     zstr_sendx (server, "CONFIG", hw_cap_path, NULL);
+    zstr_sendx (server, "ANNOUNCEWINDOW", str_announce_window, NULL);
+    zstr_sendx (server, "ANNOUNCEDELTA", announce_delta, NULL);
+    zstr_sendx (server, "LATENCYMETRICS", latency_metrics, NULL);
+    zstr_sendx (server, "ANNOUNCEINTERVAL", str_announce_interval, NULL);
+    // fill data about rackcontroller-0 from the first UPDATE of it
+    zstr_sendx (server, "RC0RUNONCE", NULL);
     zstr_sendx (server, "CONNECT", endpoint, actor_name, NULL);
     zstr_sendx (server, "CONSUMER", FTY_PROTO_STREAM_ASSETS, ".*", NULL);
     zstr_sendx (server, "PRODUCER", "ANNOUNCE", NULL);
     zstr_sendx (server, "ROOT_DIR", "/", NULL);
     zstr_sendx (server, "LINUXMETRICSINTERVAL", str_linuxmetrics_interval, NULL);
 
-    // Run once actor to fill data about rackcontroller-0
-    zactor_t *rc0_runonce = zactor_new (fty_info_rc0_runonce, (void *) RC0_RUNONCE_ACTOR);
-    zstr_sendx (rc0_runonce, "CONNECT", endpoint, actor_name, NULL);
-    zstr_sendx (rc0_runonce, "CONSUMER", FTY_PROTO_STREAM_ASSETS, "device\\.rackcontroller.*", NULL);
-
-    zloop_t *timer_loop = zloop_new();
-    zloop_timer (timer_loop, linuxmetrics_interval * 1000, 0, s_linuxmetrics_event, server);
-    zloop_start (timer_loop);
+    // metrics actor schedules collections on its own timer, just wait for termination
+    while (!zsys_interrupted) {
+        zmsg_t *msg = zmsg_recv (server);
+        zmsg_destroy (&msg);
+    }
 
     // Cleanup
-    zloop_destroy (&timer_loop);
     zactor_destroy (&server);
-    zactor_destroy (&rc0_runonce);
     zstr_free (&actor_name);
     zstr_free (&endpoint);
     zstr_free (&path);
     zstr_free (&str_linuxmetrics_interval);
+    zstr_free (&str_announce_window);
+    zstr_free (&str_announce_interval);
     zconfig_destroy (&config);
 
     return 0;
@@ -37,6 +37,10 @@
 typedef struct _topologyresolver_t topologyresolver_t;
 #define TOPOLOGYRESOLVER_T_DEFINED
 #endif
+#ifndef LOCALIDENTITY_T_DEFINED
+typedef struct _localidentity_t localidentity_t;
+#define LOCALIDENTITY_T_DEFINED
+#endif
 #ifndef FTYINFO_T_DEFINED
 typedef struct _ftyinfo_t ftyinfo_t;
 #define FTYINFO_T_DEFINED
@@ -45,14 +49,30 @@ typedef struct _ftyinfo_t ftyinfo_t;
 typedef struct _fty_info_rc0_runonce_t fty_info_rc0_runonce_t;
 #define FTY_INFO_RC0_RUNONCE_T_DEFINED
 #endif
+#ifndef FTY_INFO_METRICS_T_DEFINED
+typedef struct _fty_info_metrics_t fty_info_metrics_t;
+#define FTY_INFO_METRICS_T_DEFINED
+#endif
+#ifndef FTY_INFO_CLOCK_T_DEFINED
+typedef struct _fty_info_clock_t fty_info_clock_t;
+#define FTY_INFO_CLOCK_T_DEFINED
+#endif
+#ifndef FTY_INFO_HISTOGRAM_T_DEFINED
+typedef struct _fty_info_histogram_t fty_info_histogram_t;
+#define FTY_INFO_HISTOGRAM_T_DEFINED
+#endif
 
 //  Extra headers
 
 //  Internal API
 
 #include "topologyresolver.h"
+#include "localidentity.h"
 #include "ftyinfo.h"
 #include "fty_info_rc0_runonce.h"
+#include "fty_info_metrics.h"
+#include "fty_info_clock.h"
+#include "fty_info_histogram.h"
 
 //  *** To avoid double-definitions, only define if building without draft ***
 #ifndef FTY_INFO_BUILD_DRAFT_API
@@ -62,11 +82,31 @@ typedef struct _fty_info_rc0_runonce_t fty_info_rc0_runonce_t;
 FTY_INFO_PRIVATE void
     topologyresolver_test (bool verbose);
 
+//  *** Draft method, defined for internal use only ***
+//  Self test of this class.
+FTY_INFO_PRIVATE void
+    localidentity_test (bool verbose);
+
 //  *** Draft method, defined for internal use only ***
 //  Self test of this class.
 FTY_INFO_PRIVATE void
     fty_info_rc0_runonce_test (bool verbose);
 
+//  *** Draft method, defined for internal use only ***
+//  Self test of this class.
+FTY_INFO_PRIVATE void
+    fty_info_metrics_test (bool verbose);
+
+//  *** Draft method, defined for internal use only ***
+//  Self test of this class.
+FTY_INFO_PRIVATE void
+    fty_info_clock_test (bool verbose);
+
+//  *** Draft method, defined for internal use only ***
+//  Self test of this class.
+FTY_INFO_PRIVATE void
+    fty_info_histogram_test (bool verbose);
+
 //  Self test for private classes
 FTY_INFO_PRIVATE void
     fty_info_private_selftest (bool verbose, const char *subtest);
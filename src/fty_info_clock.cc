@@ -0,0 +1,162 @@
+/*  =========================================================================
+    fty_info_clock - Monotonic and wall clock, real or virtual
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+/*
+@header
+    fty_info_clock - Monotonic and wall clock, real or virtual
+@discuss
+    Everything scheduled by fty_info_server and fty_info_metrics, and the
+    time Linux metric rates are computed over, is read from this clock.
+    Selftests and benchmarks use a virtual clock, which is moved forward
+    explicitly, so timers fire without waiting and thousands of cycles run
+    in a second. The clock may be read from another thread than the one
+    moving it.
+@end
+*/
+
+#include "fty_info_classes.h"
+#include <atomic>
+
+//  Structure of our class
+
+struct _fty_info_clock_t {
+    bool virtual_time;
+    std::atomic<int64_t> offset;    // msec the virtual clock was advanced by
+    int64_t mono;                   // system monotonic time when created
+    int64_t time;                   // system wall time when created
+};
+
+
+//  --------------------------------------------------------------------------
+//  Create a new fty_info_clock
+
+fty_info_clock_t *
+fty_info_clock_new (bool virtual_time)
+{
+    fty_info_clock_t *self = new fty_info_clock_t;
+    assert (self);
+    //  Initialize class properties here
+    self->virtual_time = virtual_time;
+    self->offset = 0;
+    self->mono = zclock_mono ();
+    self->time = zclock_time ();
+    return self;
+}
+
+
+//  --------------------------------------------------------------------------
+//  Destroy the fty_info_clock
+
+void
+fty_info_clock_destroy (fty_info_clock_t **self_p)
+{
+    assert (self_p);
+    if (*self_p) {
+        fty_info_clock_t *self = *self_p;
+        //  Free object itself
+        delete self;
+        *self_p = NULL;
+    }
+}
+
+
+//  --------------------------------------------------------------------------
+//  Return true if the clock is virtual
+
+bool
+fty_info_clock_virtual (fty_info_clock_t *self)
+{
+    return self && self->virtual_time;
+}
+
+
+//  --------------------------------------------------------------------------
+//  Return monotonic time in msec
+
+int64_t
+fty_info_clock_mono (fty_info_clock_t *self)
+{
+    if (!self || !self->virtual_time)
+        return zclock_mono ();
+    return self->mono + self->offset;
+}
+
+
+//  --------------------------------------------------------------------------
+//  Return wall time in msec since the epoch
+
+int64_t
+fty_info_clock_time (fty_info_clock_t *self)
+{
+    if (!self || !self->virtual_time)
+        return zclock_time ();
+    return self->time + self->offset;
+}
+
+
+//  --------------------------------------------------------------------------
+//  Move virtual clock forward
+
+void
+fty_info_clock_advance (fty_info_clock_t *self, int64_t msec)
+{
+    if (self && self->virtual_time && msec > 0)
+        self->offset += msec;
+}
+
+
+//  --------------------------------------------------------------------------
+//  Self test of this class
+
+void
+fty_info_clock_test (bool verbose)
+{
+    printf (" * fty_info_clock: ");
+
+    //  @selftest
+    // real clock follows the system
+    fty_info_clock_t *real = fty_info_clock_new (false);
+    assert (!fty_info_clock_virtual (real));
+    int64_t mono = fty_info_clock_mono (real);
+    fty_info_clock_advance (real, 1000000);
+    assert (fty_info_clock_mono (real) - mono < 1000);
+    assert (fty_info_clock_mono (NULL) >= mono);
+    fty_info_clock_destroy (&real);
+
+    // virtual clock stands still until advanced
+    fty_info_clock_t *clock = fty_info_clock_new (true);
+    assert (fty_info_clock_virtual (clock));
+    mono = fty_info_clock_mono (clock);
+    int64_t time = fty_info_clock_time (clock);
+    zclock_sleep (20);
+    assert (fty_info_clock_mono (clock) == mono);
+    assert (fty_info_clock_time (clock) == time);
+    fty_info_clock_advance (clock, 30 * 1000);
+    assert (fty_info_clock_mono (clock) == mono + 30 * 1000);
+    assert (fty_info_clock_time (clock) == time + 30 * 1000);
+    // never goes back
+    fty_info_clock_advance (clock, -1000);
+    assert (fty_info_clock_mono (clock) == mono + 30 * 1000);
+    fty_info_clock_destroy (&clock);
+    assert (clock == NULL);
+    //  @end
+    printf ("OK\n");
+}
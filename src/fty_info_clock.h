@@ -0,0 +1,65 @@
+/*  =========================================================================
+    fty_info_clock - Monotonic and wall clock, real or virtual
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#ifndef FTY_INFO_CLOCK_H_INCLUDED
+#define FTY_INFO_CLOCK_H_INCLUDED
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//  @interface
+//  Create a new clock. Real clock reads the system clocks, virtual clock
+//  starts at the current system time and moves only by fty_info_clock_advance.
+FTY_INFO_PRIVATE fty_info_clock_t *
+    fty_info_clock_new (bool virtual_time);
+
+//  Destroy the clock
+FTY_INFO_PRIVATE void
+    fty_info_clock_destroy (fty_info_clock_t **self_p);
+
+//  Return true if the clock is virtual
+FTY_INFO_PRIVATE bool
+    fty_info_clock_virtual (fty_info_clock_t *self);
+
+//  Return monotonic time in msec, zclock_mono if self is NULL
+FTY_INFO_PRIVATE int64_t
+    fty_info_clock_mono (fty_info_clock_t *self);
+
+//  Return wall time in msec since the epoch, zclock_time if self is NULL
+FTY_INFO_PRIVATE int64_t
+    fty_info_clock_time (fty_info_clock_t *self);
+
+//  Move virtual clock forward by msec, no-op for real clock
+FTY_INFO_PRIVATE void
+    fty_info_clock_advance (fty_info_clock_t *self, int64_t msec);
+
+//  Self test of this class
+FTY_INFO_PRIVATE void
+    fty_info_clock_test (bool verbose);
+
+//  @end
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,222 @@
+/*  =========================================================================
+    fty_info_histogram - Fixed bucket latency histogram
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+/*
+@header
+    fty_info_histogram - Fixed bucket latency histogram
+@discuss
+    Buckets are laid out as in HdrHistogram: values below 32 have a bucket
+    each, every following power of two range is split into 16 buckets of
+    equal width. Recording is a few instructions and memory stays fixed
+    however many values are recorded, so histograms can be kept for the
+    whole life of the agent. Values up to 2^41 (25 days in usec) are told
+    apart, higher ones fall into the last bucket.
+@end
+*/
+
+#include "fty_info_classes.h"
+#include <cinttypes>
+#include <cmath>
+#include <algorithm>
+
+#define SUB_BUCKETS 16          // buckets per power of two range
+#define SUB_BUCKET_BITS 4       // log2 (SUB_BUCKETS)
+#define EXACT_LIMIT 32          // values below have a bucket each
+#define MAGNITUDE_MIN 5         // log2 (EXACT_LIMIT)
+#define MAGNITUDE_MAX 40        // highest power of two told apart
+#define BUCKETS (EXACT_LIMIT + (MAGNITUDE_MAX - MAGNITUDE_MIN + 1) * SUB_BUCKETS)
+
+//  Structure of our class
+
+struct _fty_info_histogram_t {
+    uint64_t counts [BUCKETS];
+    uint64_t count;
+    int64_t max;
+};
+
+//  Return index of bucket for value
+static int
+s_bucket (int64_t value)
+{
+    if (value < EXACT_LIMIT)
+        return value > 0 ? (int) value : 0;
+    int magnitude = 63 - __builtin_clzll ((uint64_t) value);
+    if (magnitude > MAGNITUDE_MAX)
+        return BUCKETS - 1;
+    int sub = (int) ((value >> (magnitude - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1));
+    return EXACT_LIMIT + (magnitude - MAGNITUDE_MIN) * SUB_BUCKETS + sub;
+}
+
+//  Return the highest value falling into bucket
+static int64_t
+s_bucket_top (int bucket)
+{
+    if (bucket < EXACT_LIMIT)
+        return bucket;
+    int magnitude = (bucket - EXACT_LIMIT) / SUB_BUCKETS + MAGNITUDE_MIN;
+    int sub = (bucket - EXACT_LIMIT) % SUB_BUCKETS;
+    int shift = magnitude - SUB_BUCKET_BITS;
+    return ((int64_t) (SUB_BUCKETS + sub + 1) << shift) - 1;
+}
+
+
+//  --------------------------------------------------------------------------
+//  Create a new fty_info_histogram
+
+fty_info_histogram_t *
+fty_info_histogram_new (void)
+{
+    fty_info_histogram_t *self = (fty_info_histogram_t *) zmalloc (sizeof (fty_info_histogram_t));
+    assert (self);
+    return self;
+}
+
+
+//  --------------------------------------------------------------------------
+//  Destroy the fty_info_histogram
+
+void
+fty_info_histogram_destroy (fty_info_histogram_t **self_p)
+{
+    assert (self_p);
+    if (*self_p) {
+        fty_info_histogram_t *self = *self_p;
+        //  Free object itself
+        free (self);
+        *self_p = NULL;
+    }
+}
+
+
+//  --------------------------------------------------------------------------
+//  Record one value
+
+void
+fty_info_histogram_record (fty_info_histogram_t *self, int64_t value)
+{
+    assert (self);
+    if (value < 0)
+        value = 0;
+    self->counts [s_bucket (value)]++;
+    self->count++;
+    if (value > self->max)
+        self->max = value;
+}
+
+
+//  --------------------------------------------------------------------------
+//  Return number of recorded values
+
+uint64_t
+fty_info_histogram_count (fty_info_histogram_t *self)
+{
+    assert (self);
+    return self->count;
+}
+
+
+//  --------------------------------------------------------------------------
+//  Return the highest recorded value
+
+int64_t
+fty_info_histogram_max (fty_info_histogram_t *self)
+{
+    assert (self);
+    return self->max;
+}
+
+
+//  --------------------------------------------------------------------------
+//  Return value at percentile, that is the top of the bucket where it falls
+
+int64_t
+fty_info_histogram_percentile (fty_info_histogram_t *self, double percentile)
+{
+    assert (self);
+    if (self->count == 0)
+        return 0;
+    uint64_t rank = (uint64_t) ceil (percentile / 100 * self->count);
+    if (rank < 1)
+        rank = 1;
+    uint64_t seen = 0;
+    for (int bucket = 0; bucket < BUCKETS; bucket++) {
+        seen += self->counts [bucket];
+        if (seen >= rank)
+            return std::min (s_bucket_top (bucket), self->max);
+    }
+    return self->max;
+}
+
+
+//  --------------------------------------------------------------------------
+//  Self test of this class
+
+void
+fty_info_histogram_test (bool verbose)
+{
+    printf (" * fty_info_histogram: ");
+
+    //  @selftest
+    // buckets are contiguous and each value falls under its bucket top
+    for (int64_t value = 0; value < 100000; value++) {
+        int bucket = s_bucket (value);
+        assert (value <= s_bucket_top (bucket));
+        assert (bucket == 0 || value > s_bucket_top (bucket - 1));
+    }
+    assert (s_bucket (INT64_MAX) == BUCKETS - 1);
+
+    fty_info_histogram_t *self = fty_info_histogram_new ();
+    assert (fty_info_histogram_count (self) == 0);
+    assert (fty_info_histogram_percentile (self, 99) == 0);
+
+    // small values are exact
+    for (int i = 0; i < 10; i++)
+        fty_info_histogram_record (self, 5);
+    assert (fty_info_histogram_percentile (self, 50) == 5);
+    assert (fty_info_histogram_max (self) == 5);
+    fty_info_histogram_destroy (&self);
+
+    // others at most 1/16 above
+    self = fty_info_histogram_new ();
+    for (int64_t value = 1; value <= 1000; value++)
+        fty_info_histogram_record (self, value);
+    fty_info_histogram_record (self, -7);
+    assert (fty_info_histogram_count (self) == 1001);
+    assert (fty_info_histogram_max (self) == 1000);
+    int64_t p50 = fty_info_histogram_percentile (self, 50);
+    int64_t p99 = fty_info_histogram_percentile (self, 99);
+    assert (p50 >= 500 && p50 <= 500 + 500 / 16);
+    assert (p99 >= 990 && p99 <= 1000);
+    assert (fty_info_histogram_percentile (self, 100) == 1000);
+    assert (fty_info_histogram_percentile (self, 0) == 0);
+
+    // recording is cheap
+    int64_t start = zclock_usecs ();
+    for (int64_t value = 0; value < 1000000; value++)
+        fty_info_histogram_record (self, value * 7919 % 10000000);
+    int64_t usecs = zclock_usecs () - start;
+    if (verbose)
+        printf ("\n   1000000 values recorded in %" PRIi64 " us\n", usecs);
+    fty_info_histogram_destroy (&self);
+    assert (self == NULL);
+    //  @end
+    printf ("OK\n");
+}
@@ -0,0 +1,65 @@
+/*  =========================================================================
+    fty_info_histogram - Fixed bucket latency histogram
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#ifndef FTY_INFO_HISTOGRAM_H_INCLUDED
+#define FTY_INFO_HISTOGRAM_H_INCLUDED
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//  @interface
+//  Create a new histogram
+FTY_INFO_PRIVATE fty_info_histogram_t *
+    fty_info_histogram_new (void);
+
+//  Destroy the histogram
+FTY_INFO_PRIVATE void
+    fty_info_histogram_destroy (fty_info_histogram_t **self_p);
+
+//  Record one value, negative values count as 0
+FTY_INFO_PRIVATE void
+    fty_info_histogram_record (fty_info_histogram_t *self, int64_t value);
+
+//  Return number of recorded values
+FTY_INFO_PRIVATE uint64_t
+    fty_info_histogram_count (fty_info_histogram_t *self);
+
+//  Return the highest recorded value
+FTY_INFO_PRIVATE int64_t
+    fty_info_histogram_max (fty_info_histogram_t *self);
+
+//  Return value at percentile (0 - 100), at most 1/16 above the exact one,
+//  0 if nothing was recorded
+FTY_INFO_PRIVATE int64_t
+    fty_info_histogram_percentile (fty_info_histogram_t *self, double percentile);
+
+//  Self test of this class
+FTY_INFO_PRIVATE void
+    fty_info_histogram_test (bool verbose);
+
+//  @end
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
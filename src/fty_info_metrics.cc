@@ -0,0 +1,492 @@
+/*  =========================================================================
+    fty_info_metrics - Actor collecting and publishing Linux system metrics
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+/*
+@header
+    fty_info_metrics - Actor collecting and publishing Linux system metrics
+@discuss
+    Collection reads a lot of files under /proc and /sys, so it runs on its
+    own thread with its own timer and never delays INFO replies of
+    fty_info_server. The only thing shared with the server is the internal
+    name of the rack controller, which the server sends on change.
+
+    The timer is a timerfd on CLOCK_MONOTONIC with absolute deadlines on
+    interval boundaries, so samples land on a fixed cadence however long
+    a collection takes. With a virtual fty_info_clock (CLOCK command) the
+    timerfd is not used, deadlines are checked on the TICK command sent
+    after the clock was advanced. Rates are computed over the time really
+    elapsed since the previous collection, as read from the clock.
+@end
+*/
+
+#include "fty_info_classes.h"
+#include <string>
+#include <sys/timerfd.h>
+#include <cinttypes>
+
+//  Structure of our class
+
+struct _fty_info_metrics_t {
+    char *iname;                // rack controller the metrics belong to
+    int interval;               // sec between collections, 0 if not scheduled
+    int timer_fd;               // timerfd expiring on interval boundaries
+    uint64_t missed;            // expirations missed by slow collections
+    uint64_t collections;       // collections done so far
+    fty_info_clock_t *clock;    // not owned, system clock if NULL
+    int64_t collected;          // clock mono time of the last collection, 0 if none
+    int64_t due;                // clock mono time of next collection, virtual clock only
+    std::string root_dir;       // directory to be considered / - used for testing
+    zhashx_t *history;
+    zlistx_t *cpu_sources;
+    bool test;
+    int delay;                  // msec added to every collection, testing only
+    zsock_t *report;            // not owned, pipe to report cycles to, NULL if off
+};
+
+//  --------------------------------------------------------------------------
+//  Free wrapper for zhashx destructor
+static void history_destructor(void **item) {
+    free(*item);
+}
+
+//  --------------------------------------------------------------------------
+//  Create a new fty_info_metrics
+
+fty_info_metrics_t *
+fty_info_metrics_new (void)
+{
+    fty_info_metrics_t *self = new fty_info_metrics_t;
+    assert (self);
+    //  Initialize class properties here
+    self->iname = strdup (DEFAULT_RC_INAME);
+    self->interval = 0;
+    self->timer_fd = timerfd_create (CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (self->timer_fd == -1)
+        log_error ("fty-info-metrics: can't create timer: %s", strerror (errno));
+    self->missed = 0;
+    self->collections = 0;
+    self->clock = NULL;
+    self->collected = 0;
+    self->due = 0;
+    self->root_dir = "/";
+    self->history = zhashx_new ();
+    zhashx_set_destructor (self->history, history_destructor);
+    zhashx_insert (self->history, HIST_CPU_NUMERATOR, zmalloc (sizeof (double)));
+    zhashx_insert (self->history, HIST_CPU_DENOMINATOR, zmalloc (sizeof (double)));
+    self->cpu_sources = NULL;
+    self->test = false;
+    self->delay = 0;
+    self->report = NULL;
+    return self;
+}
+
+
+//  --------------------------------------------------------------------------
+//  Destroy the fty_info_metrics
+
+void
+fty_info_metrics_destroy (fty_info_metrics_t **self_p)
+{
+    assert (self_p);
+    if (*self_p) {
+        fty_info_metrics_t *self = *self_p;
+        //  Free class properties here
+        zstr_free (&self->iname);
+        zhashx_destroy (&self->history);
+        zlistx_destroy (&self->cpu_sources);
+        if (self->timer_fd >= 0)
+            close (self->timer_fd);
+        //  Free object itself
+        delete self;
+        *self_p = NULL;
+    }
+}
+
+
+//  --------------------------------------------------------------------------
+//  Collect Linux system metrics and write them to shm
+
+void
+fty_info_metrics_publish (fty_info_metrics_t *self)
+{
+    log_debug ("fty_info_metrics_publish");
+    int64_t start = zclock_usecs ();
+
+    if (self->delay > 0)
+        zclock_sleep (self->delay);
+
+    if (!self->cpu_sources)
+        self->cpu_sources = linuxmetric_cpu_sources_new (self->root_dir);
+
+    // rates are computed over the time since the previous collection,
+    // the first one has nothing better than the interval
+    int64_t now = fty_info_clock_mono (self->clock);
+    double elapsed = self->collected ? (now - self->collected) / 1000.0 : 0;
+    if (elapsed <= 0)
+        elapsed = self->interval > 0 ? self->interval : 1;
+    self->collected = now;
+    self->collections++;
+
+    zlistx_t *info = linuxmetric_get_all
+        (elapsed,
+         self->history,
+         self->cpu_sources,
+         self->root_dir,
+         self->test);
+
+    int ttl = 3 * self->interval; // in seconds
+
+    linuxmetric_t *metric = (linuxmetric_t *) zlistx_first (info);
+    while (metric) {
+        char *value = zsys_sprintf ("%lf", metric->value);
+        log_debug ("Publishing metric %s, value %lf, unit %s", metric->type , metric->value, metric->unit);
+
+        if(fty::shm::write_metric(self->iname, metric->type, value, metric->unit, ttl) == 0) {
+            log_trace ("Metric %s published", metric->type);
+        }
+        else {
+            log_error ("Can't publish metric %s", metric->type);
+        }
+        linuxmetric_destroy (&metric);
+        metric = (linuxmetric_t *) zlistx_next (info);
+        zstr_free (&value);
+    }
+
+    zlistx_destroy (&info);
+
+    if (self->report)
+        zsock_send (self->report, "s88", "CYCLE",
+                    (uint64_t) (zclock_usecs () - start), (uint64_t) self->interval);
+}
+
+
+//  --------------------------------------------------------------------------
+//  Arm the timer to expire on every interval boundary of CLOCK_MONOTONIC,
+//  or disarm it when interval is not positive
+
+static void
+s_timer_arm (fty_info_metrics_t *self)
+{
+    if (fty_info_clock_virtual (self->clock)) {
+        int64_t interval_ms = (int64_t) self->interval * 1000;
+        int64_t now = fty_info_clock_mono (self->clock);
+        self->due = interval_ms > 0 ? (now / interval_ms + 1) * interval_ms : 0;
+    }
+    else
+        self->due = 0;
+    if (self->timer_fd < 0)
+        return;
+    struct itimerspec spec;
+    memset (&spec, 0, sizeof (spec));
+    if (self->interval > 0 && !fty_info_clock_virtual (self->clock)) {
+        struct timespec now;
+        clock_gettime (CLOCK_MONOTONIC, &now);
+        // first deadline is the next multiple of interval, kernel keeps
+        // the following ones exact
+        spec.it_value.tv_sec = (now.tv_sec / self->interval + 1) * self->interval;
+        spec.it_interval.tv_sec = self->interval;
+    }
+    if (timerfd_settime (self->timer_fd, TFD_TIMER_ABSTIME, &spec, NULL) == -1)
+        log_error ("fty-info-metrics: can't arm timer: %s", strerror (errno));
+}
+
+//  --------------------------------------------------------------------------
+//  Collect on timer expiration. Expirations missed by a collection longer
+//  than the interval are counted and skipped, next sample stays aligned.
+
+static void
+s_collect (fty_info_metrics_t *self, uint64_t expirations)
+{
+    if (expirations > 1) {
+        self->missed += expirations - 1;
+        log_warning ("fty-info-metrics: %" PRIu64 " collections missed", expirations - 1);
+    }
+    fty_info_metrics_publish (self);
+}
+
+static void
+s_handle_timer (fty_info_metrics_t *self)
+{
+    uint64_t expirations = 0;
+    if (read (self->timer_fd, &expirations, sizeof (expirations)) != sizeof (expirations))
+        return;
+    s_collect (self, expirations);
+}
+
+//  --------------------------------------------------------------------------
+//  Collect if virtual clock was advanced past the deadline, the same way
+//  as on timer expiration
+
+static void
+s_handle_tick (fty_info_metrics_t *self)
+{
+    int64_t now = fty_info_clock_mono (self->clock);
+    if (!self->due || now < self->due)
+        return;
+    int64_t interval_ms = (int64_t) self->interval * 1000;
+    uint64_t expirations = (now - self->due) / interval_ms + 1;
+    self->due += expirations * interval_ms;
+    s_collect (self, expirations);
+}
+
+
+//  --------------------------------------------------------------------------
+//  Handle pipe messages for this actor
+//  return true means continue, false means TERM
+
+static bool
+s_handle_pipe (fty_info_metrics_t *self, zsock_t *pipe, zmsg_t *message)
+{
+    if (!message)
+        return true;
+    char *command = zmsg_popstr (message);
+    if (!command) {
+        zmsg_destroy (&message);
+        log_warning ("Empty command.");
+        return true;
+    }
+    if (streq (command, "CLOCK")) {
+        // clock of the owner, it outlives the actor
+        zframe_t *frame = zmsg_pop (message);
+        if (frame && zframe_size (frame) == sizeof (void *))
+            memcpy (&self->clock, zframe_data (frame), sizeof (void *));
+        zframe_destroy (&frame);
+        s_timer_arm (self);
+        zstr_free (&command);
+        zmsg_destroy (&message);
+        return true;
+    }
+    char *arg = zmsg_popstr (message);
+    bool ret = true;
+    if (streq (command, "$TERM")) {
+        log_info ("Got $TERM");
+        ret = false;
+    }
+    else
+    if (streq (command, "INAME")) {
+        if (arg) {
+            zstr_free (&self->iname);
+            self->iname = strdup (arg);
+        }
+    }
+    else
+    if (streq (command, "INTERVAL")) {
+        self->interval = arg ? (int) strtol (arg, NULL, 10) : 0;
+        s_timer_arm (self);
+    }
+    else
+    if (streq (command, "ROOT_DIR")) {
+        if (arg) {
+            self->root_dir.assign (arg);
+            // sources will be discovered again under the new root
+            zlistx_destroy (&self->cpu_sources);
+        }
+    }
+    else
+    if (streq (command, "TEST")) {
+        self->test = arg && streq (arg, "1");
+    }
+    else
+    if (streq (command, "DELAY")) {
+        self->delay = arg ? (int) strtol (arg, NULL, 10) : 0;
+    }
+    else
+    if (streq (command, "PUBLISH")) {
+        fty_info_metrics_publish (self);
+    }
+    else
+    if (streq (command, "TICK")) {
+        s_handle_tick (self);
+    }
+    else
+    if (streq (command, "STATS")) {
+        zsock_send (pipe, "s88", "STATS", self->collections, self->missed);
+    }
+    else
+    if (streq (command, "REPORT")) {
+        self->report = arg && streq (arg, "1") ? pipe : NULL;
+    }
+    else
+        log_error ("fty-info-metrics: Unknown actor command: %s.\n", command);
+
+    zstr_free (&arg);
+    zstr_free (&command);
+    zmsg_destroy (&message);
+    return ret;
+}
+
+
+//  --------------------------------------------------------------------------
+//  Actor main thread
+
+void
+fty_info_metrics (zsock_t *pipe, void *args)
+{
+    fty_info_metrics_t *self = fty_info_metrics_new ();
+
+    zpoller_t *poller = zpoller_new (pipe, NULL);
+    assert (poller);
+    if (self->timer_fd >= 0)
+        zpoller_add (poller, &self->timer_fd);
+
+    zsock_signal (pipe, 0);
+    log_info ("fty-info-metrics: Started");
+
+    while (!zsys_interrupted)
+    {
+        void *which = zpoller_wait (poller, TIMEOUT_MS);
+        if (which == NULL) {
+            if (zpoller_terminated (poller) || zsys_interrupted) {
+                break;
+            }
+        }
+        if (which == pipe) {
+            if (!s_handle_pipe (self, pipe, zmsg_recv (pipe)))
+                break;  //TERM
+        }
+        else
+        if (which == &self->timer_fd) {
+            s_handle_timer (self);
+        }
+    }
+
+    zpoller_destroy (&poller);
+    fty_info_metrics_destroy (&self);
+}
+
+
+//  --------------------------------------------------------------------------
+//  Self test of this class
+
+void
+fty_info_metrics_test (bool verbose)
+{
+    printf (" * fty_info_metrics: ");
+
+    //  @selftest
+    // Note: If your selftest reads SCMed fixture data, please keep it in
+    // src/selftest-ro; if your test creates filesystem objects, please
+    // do so under src/selftest-rw. They are defined below along with a
+    // usecase for the variables (assert) to make compilers happy.
+    const char *SELFTEST_DIR_RO = "src/selftest-ro";
+    const char *SELFTEST_DIR_RW = "src/selftest-rw";
+    assert (SELFTEST_DIR_RO);
+    assert (SELFTEST_DIR_RW);
+    assert (fty_shm_set_test_dir (SELFTEST_DIR_RW) == 0);
+
+    // collection writes metrics of the given rack controller
+    fty_info_metrics_t *self = fty_info_metrics_new ();
+    assert (self);
+    self->root_dir = std::string (SELFTEST_DIR_RO) + "/data/";
+    self->interval = 30;
+    self->test = true;
+    zstr_free (&self->iname);
+    self->iname = strdup ("rackcontroller-metrics");
+    fty_info_metrics_publish (self);
+
+    // deadlines are aligned to interval boundaries
+    struct itimerspec spec;
+    struct timespec now;
+    s_timer_arm (self);
+    assert (timerfd_gettime (self->timer_fd, &spec) == 0);
+    clock_gettime (CLOCK_MONOTONIC, &now);
+    assert (spec.it_interval.tv_sec == 30 && spec.it_interval.tv_nsec == 0);
+    assert (spec.it_value.tv_sec < 30 || (spec.it_value.tv_sec == 30 && spec.it_value.tv_nsec == 0));
+    int64_t deadline_ms = (now.tv_sec + spec.it_value.tv_sec) * 1000
+        + (now.tv_nsec + spec.it_value.tv_nsec) / 1000000;
+    int64_t offset_ms = deadline_ms % (30 * 1000);
+    assert (offset_ms < 5 || offset_ms > 30 * 1000 - 5);
+    self->interval = 0;
+    s_timer_arm (self);
+    assert (timerfd_gettime (self->timer_fd, &spec) == 0);
+    assert (spec.it_value.tv_sec == 0 && spec.it_value.tv_nsec == 0);
+    fty_info_metrics_destroy (&self);
+
+    fty::shm::shmMetrics results;
+    fty::shm::read_metrics ("rackcontroller-metrics", LINUXMETRIC_UPTIME, results);
+    assert (results.size () == 1);
+    for (auto &metric : results)
+        assert (1000000 == atoi (fty_proto_value (metric)));
+
+    // actor collects on its own timer
+    zactor_t *metrics = zactor_new (fty_info_metrics, NULL);
+    std::string root_dir = std::string (SELFTEST_DIR_RO) + "/data/";
+    zstr_sendx (metrics, "ROOT_DIR", root_dir.c_str (), NULL);
+    zstr_sendx (metrics, "TEST", "1", NULL);
+    zstr_sendx (metrics, "INAME", "rackcontroller-timer", NULL);
+    zstr_sendx (metrics, "INTERVAL", "1", NULL);
+    zclock_sleep (1500);
+    zactor_destroy (&metrics);
+
+    fty::shm::shmMetrics timer_results;
+    fty::shm::read_metrics ("rackcontroller-timer", LINUXMETRIC_UPTIME, timer_results);
+    assert (timer_results.size () == 1);
+
+    // virtual clock: collections are due as soon as the clock is advanced
+    fty_info_clock_t *clock = fty_info_clock_new (true);
+    metrics = zactor_new (fty_info_metrics, NULL);
+    zstr_sendx (metrics, "ROOT_DIR", root_dir.c_str (), NULL);
+    zstr_sendx (metrics, "TEST", "1", NULL);
+    zstr_sendx (metrics, "INAME", "rackcontroller-virtual", NULL);
+    zsock_send (metrics, "sp", "CLOCK", clock);
+    zstr_sendx (metrics, "INTERVAL", "1", NULL);
+    const uint64_t cycles = 1000;
+    uint64_t collections = 0, missed = 0;
+    int64_t start = zclock_usecs ();
+    for (uint64_t i = 0; i < cycles; i++) {
+        fty_info_clock_advance (clock, 1000);
+        zstr_sendx (metrics, "TICK", NULL);
+        zstr_sendx (metrics, "STATS", NULL);
+        assert (zsock_recv (metrics, "s88", NULL, &collections, &missed) == 0);
+    }
+    int64_t usecs = zclock_usecs () - start;
+    assert (collections == cycles && missed == 0);
+    // nothing is due before the next boundary
+    fty_info_clock_advance (clock, 500);
+    zstr_sendx (metrics, "TICK", NULL);
+    zstr_sendx (metrics, "STATS", NULL);
+    assert (zsock_recv (metrics, "s88", NULL, &collections, &missed) == 0);
+    assert (collections == cycles && missed == 0);
+    // jump over 10 boundaries, one collection and 9 missed
+    fty_info_clock_advance (clock, 10 * 1000);
+    zstr_sendx (metrics, "TICK", NULL);
+    zstr_sendx (metrics, "STATS", NULL);
+    assert (zsock_recv (metrics, "s88", NULL, &collections, &missed) == 0);
+    assert (collections == cycles + 1 && missed == 9);
+    // every collection is reported with its duration once asked to
+    zstr_sendx (metrics, "REPORT", "1", NULL);
+    fty_info_clock_advance (clock, 1000);
+    zstr_sendx (metrics, "TICK", NULL);
+    char *tag = NULL;
+    uint64_t cycle_usecs = 0, interval = 0;
+    assert (zsock_recv (metrics, "s88", &tag, &cycle_usecs, &interval) == 0);
+    assert (streq (tag, "CYCLE") && interval == 1);
+    zstr_free (&tag);
+    zactor_destroy (&metrics);
+    fty_info_clock_destroy (&clock);
+    if (verbose)
+        printf ("\n   %" PRIu64 " virtual cycles in %" PRIi64 " us, %.0f cycles/s\n",
+                cycles, usecs, cycles * 1e6 / (usecs > 0 ? usecs : 1));
+
+    fty_shm_delete_test_dir ();
+    //  @end
+    printf ("OK\n");
+}
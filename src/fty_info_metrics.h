@@ -0,0 +1,69 @@
+/*  =========================================================================
+    fty_info_metrics - Actor collecting and publishing Linux system metrics
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#ifndef FTY_INFO_METRICS_H_INCLUDED
+#define FTY_INFO_METRICS_H_INCLUDED
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//  @interface
+//  Create a new fty_info_metrics
+FTY_INFO_PRIVATE fty_info_metrics_t *
+    fty_info_metrics_new (void);
+
+//  Destroy the fty_info_metrics
+FTY_INFO_PRIVATE void
+    fty_info_metrics_destroy (fty_info_metrics_t **self_p);
+
+//  Collect Linux system metrics and write them to shm
+FTY_INFO_PRIVATE void
+    fty_info_metrics_publish (fty_info_metrics_t *self);
+
+//  Actor collecting metrics every interval. Commands on the pipe:
+//      INAME/<iname>       - rack controller the metrics belong to
+//      INTERVAL/<sec>      - collect every interval, 0 stops collecting
+//      ROOT_DIR/<dir>      - directory to be considered /
+//      TEST/<0|1>          - collect the test set of metrics
+//      DELAY/<msec>        - make every collection slower, testing only
+//      PUBLISH             - collect now
+//      CLOCK/<pointer>     - fty_info_clock_t to read time from, sent by
+//                            zsock_send "sp", must outlive the actor
+//      TICK                - virtual clock was advanced, collect if due
+//      STATS               - reply collections and missed ones,
+//                            "s88" STATS/<collections>/<missed>
+//      REPORT/<0|1>        - after every collection send "s88"
+//                            CYCLE/<usec it took>/<interval>
+FTY_INFO_PRIVATE void
+    fty_info_metrics (zsock_t *pipe, void *args);
+
+//  Self test of this class
+FTY_INFO_PRIVATE void
+    fty_info_metrics_test (bool verbose);
+
+//  @end
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -40,8 +40,16 @@ fty_info_private_selftest (bool verbose, const char *subtest)
 // Tests for stable private classes:
     if (streq (subtest, "$ALL") || streq (subtest, "topologyresolver_test"))
         topologyresolver_test (verbose);
+    if (streq (subtest, "$ALL") || streq (subtest, "localidentity_test"))
+        localidentity_test (verbose);
     if (streq (subtest, "$ALL") || streq (subtest, "fty_info_rc0_runonce_test"))
         fty_info_rc0_runonce_test (verbose);
+    if (streq (subtest, "$ALL") || streq (subtest, "fty_info_metrics_test"))
+        fty_info_metrics_test (verbose);
+    if (streq (subtest, "$ALL") || streq (subtest, "fty_info_clock_test"))
+        fty_info_clock_test (verbose);
+    if (streq (subtest, "$ALL") || streq (subtest, "fty_info_histogram_test"))
+        fty_info_histogram_test (verbose);
 }
 /*
 ################################################################################
@@ -27,6 +27,7 @@
 */
 
 #include "fty_info_classes.h"
+#include <string>
 
 //  Structure of our class
 
@@ -49,7 +50,8 @@ fty_info_rc0_runonce_new (char *name)
     assert (self);
     //  Initialize class properties here
     self->name=strdup(name);
-    self->client = mlm_client_new ();
+    // client is created by the actor, fty_info_server passes its own
+    self->client = NULL;
     self->resolver = topologyresolver_new (DEFAULT_RC_INAME);
     self->info = ftyinfo_new (self->resolver, DEFAULT_PATH);
     return self;
@@ -79,50 +81,40 @@ fty_info_rc0_runonce_destroy (fty_info_rc0_runonce_t **self_p)
 
 
 //  --------------------------------------------------------------------------
-//  Handle stream messages for this actor
+//  Handle asset message, ASSET_MANIPULATION is sent through client.
+//  Return 1 when rackcontroller-0 was updated, 0 if message was not about
+//  it, -1 on error. Message stays owned by caller.
 
 int
-handle_stream(fty_info_rc0_runonce_t *self, zmsg_t *msg)
+fty_info_rc0_runonce_asset (fty_info_rc0_runonce_t *self, mlm_client_t *client, fty_proto_t *asset)
 {
-    if (NULL == self || NULL == msg) {
-        return -1;
-    }
-    if (!is_fty_proto (msg)){
-        zmsg_destroy (&msg);
-        return 0;
-    }
-    fty_proto_t *message = fty_proto_decode (&msg);
-    if (NULL == message ) {
-        log_error ("can't decode message with subject %s, ignoring", mlm_client_subject (self->client));
+    if (NULL == self || NULL == client || NULL == asset) {
         return -1;
     }
-    if (fty_proto_id (message) != FTY_PROTO_ASSET) {
+    if (fty_proto_id (asset) != FTY_PROTO_ASSET) {
         log_debug("Not FTY_PROTO_ASSET");
-        fty_proto_destroy (&message);
         return 0;
     }
 
-    const char *operation = fty_proto_operation (message);
+    const char *operation = fty_proto_operation (asset);
     if (operation && !streq (operation, FTY_PROTO_ASSET_OP_UPDATE)) {
         log_debug("Not FTY_PROTO_ASSET_OP_UPDATE");
-        fty_proto_destroy (&message);
         return 0;
     }
 
-    const char *type = fty_proto_aux_string (message, "type", "");
-    const char *subtype = fty_proto_aux_string (message, "subtype", "");
+    const char *type = fty_proto_aux_string (asset, "type", "");
+    const char *subtype = fty_proto_aux_string (asset, "subtype", "");
     if (!streq (type, "device") || !streq (subtype, "rackcontroller")) {
         log_debug ("Not device.rackcontroller");
-        fty_proto_destroy (&message);
         return 0;
     }
 
-    const char *iname = fty_proto_name(message);
+    const char *iname = fty_proto_name(asset);
     if (NULL == iname || !streq(iname, DEFAULT_RC_INAME)) {
         log_debug("Not %s", DEFAULT_RC_INAME);
-        fty_proto_destroy (&message);
         return 0;
     }
+    fty_proto_t *message = fty_proto_dup (asset);
 
     // just for rackcontroller-0
     int changeRW = 0;
@@ -210,35 +202,15 @@ handle_stream(fty_info_rc0_runonce_t *self, zmsg_t *msg)
 
     data = fty_proto_ext_string(message, "ip.1", NULL);
     if (NULL == data) {
-        struct ifaddrs *interfaces, *iface;
-        char host[NI_MAXHOST];
-        if (getifaddrs (&interfaces) != -1) {
-            int counter = 0;
-            for (iface = interfaces; iface != NULL; iface = iface->ifa_next) {
-                if (iface->ifa_addr == NULL) continue;
-                // here we support IPv4 only, only get first 3 addresses
-                if (iface->ifa_addr->sa_family == AF_INET &&
-                        getnameinfo(iface->ifa_addr,sizeof(struct sockaddr_in),
-                                host, NI_MAXHOST, NULL, 0, NI_NUMERICHOST) == 0) {
-                    switch(counter) {
-                        case 0:
-                            fty_proto_ext_insert(messageRO, "ip.1", "%s", host);
-                            break;
-                        case 1:
-                            fty_proto_ext_insert(messageRO, "ip.2", "%s", host);
-                            break;
-                        case 2:
-                            fty_proto_ext_insert(messageRO, "ip.3", "%s", host);
-                            break;
-                    }
-                    changeRO = 1;
-                    ++counter;
-                }
-                if (counter == 3) {
-                    break;
-                }
+        // here we support IPv4 only, only get first 3 addresses
+        char *ip[3];
+        localidentity_ipv4 (localidentity_shared (), ip);
+        for (int i = 0; i < 3; ++i) {
+            if (ip[i]) {
+                fty_proto_ext_insert(messageRO, ("ip." + std::to_string (i + 1)).c_str (), "%s", ip[i]);
+                changeRO = 1;
             }
-            freeifaddrs(interfaces);
+            zstr_free (&ip[i]);
         }
     }
 
@@ -246,7 +218,7 @@ handle_stream(fty_info_rc0_runonce_t *self, zmsg_t *msg)
         fty_proto_t *messageDup = fty_proto_dup(messageRO);
         zmsg_t *msgDup = fty_proto_encode(&messageDup);
         zmsg_pushstrf (msgDup, "%s", "READONLY");
-        int rv = mlm_client_sendto(self->client, "asset-agent", "ASSET_MANIPULATION", NULL, 10, &msgDup);
+        int rv = mlm_client_sendto(client, "asset-agent", "ASSET_MANIPULATION", NULL, 10, &msgDup);
         if (rv == -1) {
             log_error("Failed to send ASSET_MANIPULATION message to asset-agent");
             fty_proto_destroy (&message);
@@ -259,7 +231,7 @@ handle_stream(fty_info_rc0_runonce_t *self, zmsg_t *msg)
         fty_proto_t *messageDup = fty_proto_dup(messageRW);
         zmsg_t *msgDup = fty_proto_encode(&messageDup);
         zmsg_pushstrf (msgDup, "%s", "READWRITE");
-        int rv = mlm_client_sendto(self->client, "asset-agent", "ASSET_MANIPULATION", NULL, 10, &msgDup);
+        int rv = mlm_client_sendto(client, "asset-agent", "ASSET_MANIPULATION", NULL, 10, &msgDup);
         if (rv == -1) {
             log_error("Failed to send ASSET_MANIPULATION message to asset-agent");
             fty_proto_destroy (&message);
@@ -276,6 +248,30 @@ handle_stream(fty_info_rc0_runonce_t *self, zmsg_t *msg)
 }
 
 
+//  --------------------------------------------------------------------------
+//  Handle stream messages for this actor
+
+int
+handle_stream(fty_info_rc0_runonce_t *self, zmsg_t *msg)
+{
+    if (NULL == self || NULL == msg) {
+        return -1;
+    }
+    if (!is_fty_proto (msg)){
+        zmsg_destroy (&msg);
+        return 0;
+    }
+    fty_proto_t *message = fty_proto_decode (&msg);
+    if (NULL == message ) {
+        log_error ("can't decode message with subject %s, ignoring", mlm_client_subject (self->client));
+        return -1;
+    }
+    int rv = fty_info_rc0_runonce_asset (self, self->client, message);
+    fty_proto_destroy (&message);
+    return rv;
+}
+
+
 //  --------------------------------------------------------------------------
 //  Handle pipe messages for this actor
 
@@ -342,6 +338,7 @@ void fty_info_rc0_runonce (zsock_t *pipe, void *args)
         return;
     }
     fty_info_rc0_runonce_t *self = fty_info_rc0_runonce_new (name);
+    self->client = mlm_client_new ();
 
     zpoller_t *poller = zpoller_new (pipe, mlm_client_msgpipe (self->client), NULL);
     assert (poller);
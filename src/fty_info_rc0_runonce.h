@@ -35,6 +35,11 @@ FTY_INFO_PRIVATE fty_info_rc0_runonce_t *
 FTY_INFO_PRIVATE void
     fty_info_rc0_runonce_destroy (fty_info_rc0_runonce_t **self_p);
 
+//  Handle asset message, send ASSET_MANIPULATION through client if it is
+//  about rackcontroller-0. Return 1 when updated, 0 if not about it, -1 on error
+FTY_INFO_PRIVATE int
+    fty_info_rc0_runonce_asset (fty_info_rc0_runonce_t *self, mlm_client_t *client, fty_proto_t *asset);
+
 //  Run once agent to update rackcontroller-0 first time it is created
 FTY_INFO_EXPORT void
     fty_info_rc0_runonce (zsock_t *pipe, void *args);
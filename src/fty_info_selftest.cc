@@ -43,7 +43,11 @@ all_tests [] = {
 // Tests for stable/draft private classes:
 // Now built only with --enable-drafts, so even stable builds are hidden behind the flag
     { "topologyresolver", NULL, true, false, "topologyresolver_test" },
+    { "localidentity", NULL, true, false, "localidentity_test" },
     { "fty_info_rc0_runonce", NULL, true, false, "fty_info_rc0_runonce_test" },
+    { "fty_info_metrics", NULL, true, false, "fty_info_metrics_test" },
+    { "fty_info_clock", NULL, true, false, "fty_info_clock_test" },
+    { "fty_info_histogram", NULL, true, false, "fty_info_histogram_test" },
     { "private_classes", NULL, false, false, "$ALL" }, // compat option for older projects
 #endif // FTY_INFO_BUILD_DRAFT_API
 #ifdef FTY_INFO_BUILD_DRAFT_API
@@ -31,28 +31,99 @@
 #include <cxxtools/jsondeserializer.h>
 #include <istream>
 #include <fstream>
+#include <sstream>
 #include <set>
 #include <map>
 #include <ifaddrs.h>
+#include <cinttypes>
+#include <algorithm>
+#include <vector>
+#include <libgen.h>
+#include <sys/inotify.h>
 
 #include "fty_info_classes.h"
 
 #define HW_CAP_FILE "42ity-capabilities.dsc"
+#define HOSTNAME_FILE "/etc/hostname"
+// consecutive DELTA announces before a full UPDATE is sent again
+#define ANNOUNCE_DELTA_MAX 10
+// longest narrowed ASSETS pattern, zrex compiles into fixed size buffers
+#define ASSETS_PATTERN_MAX 200
+// most ASSETS messages processed before mailbox is checked again
+#define ASSETS_BATCH 100
+// most batches, or msec, the topology is not resolved while ASSETS keep coming
+#define ASSETS_COMMIT_BATCHES 50
+#define ASSETS_COMMIT_MS 1000
+// most messages waiting in outbox, the oldest is dropped when it is full
+#define OUTBOX_MAX 1000
+// failed sends of a message before it is dropped
+#define OUTBOX_RETRIES 5
+// msec before outbox is flushed again when client did not accept a message,
+// doubled on every flush which does not empty it, up to OUTBOX_RETRY_MAX_MS
+#define OUTBOX_RETRY_MS 10
+#define OUTBOX_RETRY_MAX_MS 1000
 
 struct _fty_info_server_t {
     //  Declare class properties here
     char* name;
     char* endpoint;
     char* path;
-    mlm_client_t *client;
-    mlm_client_t *announce_client;
+    mlm_client_t *client;           // mailbox, ANNOUNCE producer and requests to asset agent
+    bool announce_producer;         // client is producer on ANNOUNCE stream
+    mlm_client_t *assets_client;    // consumer of ASSETS, replaced when its pattern is narrowed
+    zpoller_t *poller;
     bool first_announce;
     bool test;
     topologyresolver_t* resolver;
-    int linuxmetrics_interval;
-    std::string root_dir; //directory to be considered / - used for testing
-    zhashx_t *history;
+    zactor_t *metrics;          // collects Linux metrics on its own thread
+    fty_info_clock_t *clock;    // virtual clock for testing, system clock if NULL
+    fty_info_rc0_runonce_t *rc0;    // updates rackcontroller-0 once, NULL when done
+    char *metrics_iname;        // rack controller iname last sent to metrics
     char *hw_cap_path;
+    ftyinfo_t *info;            // INFO snapshot, rebuilt only when its inputs change
+    ftyinfo_t *test_info;       // INFO-TEST snapshot, never changes
+    zmsg_t *info_msg;           // encoded INFO snapshot, template for replies and announces
+    zmsg_t *test_info_msg;      // encoded INFO-TEST snapshot
+    uint64_t info_version;      // increases when encoded INFO snapshot changes
+    int watch_fd;               // inotify watching files parsed into INFO
+    std::map<int, std::string> watch_dirs;  // watch descriptor -> directory
+    std::set<std::string> watch_files;      // files parsed into INFO
+    int identity_fd;            // netlink socket of shared local identity
+    uint64_t info_identity;     // local identity generation of the snapshot
+    uint64_t info_generation;   // topology resolver generation of the snapshot
+    bool info_stale;            // configuration changed since the snapshot
+    int announce_window;        // msec to coalesce announces triggered by assets
+    int64_t announce_due;       // monotonic time of pending announce, 0 if none
+    uint64_t announce_hash;     // hash of the last published announce
+    uint64_t announce_published;    // number of published announces
+    uint64_t announce_coalesced;    // requests merged into a pending announce
+    uint64_t announce_unchanged;    // announces dropped, INFO did not change
+    bool announce_delta;        // publish DELTA instead of full UPDATE
+    int announce_deltas;        // DELTA announces since the last full one
+    uint64_t announce_version;  // INFO version of the last published announce
+    zhash_t *announce_infos;    // INFO hash of the last published announce
+    int announce_interval;      // sec of silence before HEARTBEAT, 0 disables it
+    int64_t heartbeat_due;      // monotonic time of next HEARTBEAT, 0 if none
+    zmsg_t *versioned_msg[2];   // encoded INFO and INFO-TEST with version, rebuilt when INFO changes
+    uint64_t versioned_version[2];  // INFO version of versioned_msg
+    uint64_t announce_heartbeats;   // number of published heartbeats
+    char *assets_pattern;       // current pattern of the ASSETS consumer
+    uint64_t assets_decoded;    // ASSETS messages decoded
+    uint64_t assets_skipped;    // ASSETS messages dropped undecoded, not about topology
+    bool assets_hold;           // testing only, ASSETS consumer is not polled
+    int assets_batches;         // ASSETS batches since the last commit to resolver
+    int64_t assets_begun;       // clock mono time of the first of them, 0 if none
+    zlistx_t *outbox;           // messages waiting for client: address/subject/timeout/content
+    int outbox_attempts;        // failed sends of the first message in outbox
+    int outbox_backoff;         // msec between flushes while client does not accept
+    int64_t outbox_due;         // clock mono time of next flush, 0 if none
+    bool outbox_hold;           // testing only, messages stay in outbox
+    uint64_t outbox_sent;       // messages handed over to client
+    uint64_t outbox_queued;     // messages which had to wait in outbox
+    uint64_t outbox_retried;    // failed sends tried again
+    uint64_t outbox_dropped;    // messages dropped, outbox full or out of retries
+    zhashx_t *latencies;        // kind of work -> fty_info_histogram_t of usec it took
+    bool latency_metrics;       // publish latency percentiles with Linux metrics
 };
 
 // this is kept for to handle with values set to ""
@@ -66,34 +137,74 @@ s_get (zconfig_t *config, const char* key, const char*dfl) {
     return ret;
 }
 
-//  --------------------------------------------------------------------------
-//  Free wrapper for zhashx destructor
-static void history_destructor(void **item) {
-    free(*item);
-}
-
 //  --------------------------------------------------------------------------
 //  Create a new fty_info_server
 
 fty_info_server_t  *
 info_server_new (char *name)
 {
-    double *numerator_ptr = (double *)zmalloc(sizeof(double));
-    double *denominator_ptr = (double *)zmalloc(sizeof(double));
     fty_info_server_t *self = new fty_info_server_t;
     assert (self);
     //  Initialize class properties here
     self->name=strdup(name);
     self->client = mlm_client_new ();
-    self->announce_client = mlm_client_new ();
+    self->announce_producer = false;
+    self->assets_client = NULL;
+    self->poller = NULL;
     self->first_announce=true;
     self->test = false;
-    self->history = zhashx_new();
+    self->metrics = NULL;
+    self->clock = NULL;
+    self->rc0 = NULL;
+    self->metrics_iname = NULL;
+    self->endpoint = NULL;
+    self->path = NULL;
+    self->info = NULL;
+    self->test_info = NULL;
+    self->info_msg = NULL;
+    self->test_info_msg = NULL;
+    self->info_version = 0;
+    self->watch_fd = -1;
+    self->identity_fd = -1;
+    self->info_identity = 0;
+    self->info_generation = 0;
+    self->info_stale = true;
+    self->announce_window = atoi (STR_DEFAULT_ANNOUNCE_WINDOW_MS);
+    self->announce_due = 0;
+    self->announce_hash = 0;
+    self->announce_published = 0;
+    self->announce_coalesced = 0;
+    self->announce_unchanged = 0;
+    self->announce_delta = false;
+    self->announce_deltas = 0;
+    self->announce_version = 0;
+    self->announce_infos = NULL;
+    self->announce_interval = DEFAULT_ANNOUNCE_INTERVAL_SEC;
+    self->heartbeat_due = 0;
+    self->versioned_msg[0] = self->versioned_msg[1] = NULL;
+    self->versioned_version[0] = self->versioned_version[1] = 0;
+    self->announce_heartbeats = 0;
+    self->assets_pattern = NULL;
+    self->assets_decoded = 0;
+    self->assets_skipped = 0;
+    self->assets_hold = false;
+    self->assets_batches = 0;
+    self->assets_begun = 0;
+    self->outbox = zlistx_new ();
+    zlistx_set_destructor (self->outbox, (void (*)(void**)) zmsg_destroy);
+    self->outbox_attempts = 0;
+    self->outbox_backoff = OUTBOX_RETRY_MS;
+    self->outbox_due = 0;
+    self->outbox_hold = false;
+    self->outbox_sent = 0;
+    self->outbox_queued = 0;
+    self->outbox_retried = 0;
+    self->outbox_dropped = 0;
+    self->latencies = zhashx_new ();
+    zhashx_set_destructor (self->latencies, (void (*)(void**)) fty_info_histogram_destroy);
+    self->latency_metrics = false;
     self->hw_cap_path = NULL;
     self->resolver = topologyresolver_new (DEFAULT_RC_INAME);
-    zhashx_set_destructor(self->history, history_destructor);
-    zhashx_insert(self->history, HIST_CPU_NUMERATOR, numerator_ptr);
-    zhashx_insert(self->history, HIST_CPU_DENOMINATOR, denominator_ptr);
     return self;
 }
 //  --------------------------------------------------------------------------
@@ -106,14 +217,30 @@ info_server_destroy (fty_info_server_t  **self_p)
     if (*self_p) {
         fty_info_server_t  *self = *self_p;
         //  Free class properties here
+        zlistx_destroy (&self->outbox);
         mlm_client_destroy (&self->client);
-        mlm_client_destroy (&self->announce_client);
+        fty_info_rc0_runonce_destroy (&self->rc0);
+        mlm_client_destroy (&self->assets_client);
+        zstr_free(&self->assets_pattern);
         zstr_free(&self->name);
         zstr_free(&self->endpoint);
         zstr_free(&self->path);
         topologyresolver_destroy (&self->resolver);
-        zhashx_destroy(&self->history);
+        zactor_destroy (&self->metrics);
+        // metrics actor is gone, nobody reads the clock any more
+        fty_info_clock_destroy (&self->clock);
+        zstr_free (&self->metrics_iname);
+        ftyinfo_destroy (&self->info);
+        ftyinfo_destroy (&self->test_info);
+        zmsg_destroy (&self->info_msg);
+        zmsg_destroy (&self->test_info_msg);
+        zhash_destroy (&self->announce_infos);
+        zmsg_destroy (&self->versioned_msg[0]);
+        zmsg_destroy (&self->versioned_msg[1]);
+        if (self->watch_fd >= 0)
+            close (self->watch_fd);
         zstr_free(&self->hw_cap_path);
+        zhashx_destroy (&self->latencies);
         //  Free object itself
         delete self;
         *self_p = NULL;
@@ -198,82 +325,800 @@ s_create_info (ftyinfo_t *info)
     return msg;
 }
 
+//  --------------------------------------------------------------------------
+//  Return true if both messages have the same frames
+static bool
+s_zmsg_eq (zmsg_t *a, zmsg_t *b)
+{
+    if (!a || !b)
+        return a == b;
+    if (zmsg_size (a) != zmsg_size (b))
+        return false;
+    zframe_t *frame_a = zmsg_first (a);
+    zframe_t *frame_b = zmsg_first (b);
+    while (frame_a && frame_b) {
+        if (!zframe_eq (frame_a, frame_b))
+            return false;
+        frame_a = zmsg_next (a);
+        frame_b = zmsg_next (b);
+    }
+    return true;
+}
+
+//  --------------------------------------------------------------------------
+//  Create DELTA announce from encoded INFO and hash of the previous announce:
+//  INFO/name/type/subtype/port/version/base version/changed/removed
+//  changed is packed hash of new and modified keys, removed is packed hash
+//  of removed keys with empty values.
+static zmsg_t *
+s_create_delta (zmsg_t *info_msg, zhash_t *base, uint64_t version, uint64_t base_version)
+{
+    zmsg_t *msg = zmsg_new ();
+    zframe_t *frame = zmsg_first (info_msg);
+    for (int i = 0; i < 5 && frame; i++) {
+        zframe_t *copy = zframe_dup (frame);
+        zmsg_append (msg, &copy);
+        frame = zmsg_next (info_msg);
+    }
+    zmsg_addstrf (msg, "%" PRIu64, version);
+    zmsg_addstrf (msg, "%" PRIu64, base_version);
+
+    zhash_t *infos = zhash_unpack (zmsg_last (info_msg));
+    zhash_t *changed = zhash_new ();
+    zhash_t *removed = zhash_new ();
+    char *value = (char *) zhash_first (infos);
+    while (value) {
+        const char *key = zhash_cursor (infos);
+        char *old_value = (char *) zhash_lookup (base, key);
+        if (!old_value || !streq (old_value, value))
+            zhash_insert (changed, key, value);
+        value = (char *) zhash_next (infos);
+    }
+    value = (char *) zhash_first (base);
+    while (value) {
+        const char *key = zhash_cursor (base);
+        if (!zhash_lookup (infos, key))
+            zhash_insert (removed, key, (void *) "");
+        value = (char *) zhash_next (base);
+    }
+
+    frame = zhash_pack (changed);
+    zmsg_append (msg, &frame);
+    frame = zhash_pack (removed);
+    zmsg_append (msg, &frame);
+
+    zhash_destroy (&removed);
+    zhash_destroy (&changed);
+    zhash_destroy (&infos);
+    return msg;
+}
+
+//  --------------------------------------------------------------------------
+//  Return FNV-1a hash of all frames of the message
+static uint64_t
+s_zmsg_hash (zmsg_t *msg)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    zframe_t *frame = zmsg_first (msg);
+    while (frame) {
+        const unsigned char *data = zframe_data (frame);
+        size_t size = zframe_size (frame);
+        // frame boundaries are part of the content
+        for (size_t i = 0; i < sizeof (size); i++) {
+            hash ^= (size >> (8 * i)) & 0xFF;
+            hash *= 1099511628211ULL;
+        }
+        for (size_t i = 0; i < size; i++) {
+            hash ^= data[i];
+            hash *= 1099511628211ULL;
+        }
+        frame = zmsg_next (msg);
+    }
+    return hash;
+}
+
+//  --------------------------------------------------------------------------
+//  Return INFO snapshot, rebuild it first if topology, configuration or any
+//  of the system inputs (parsed files, hostname, addresses) changed.
+//  Encoded INFO message is rebuilt together with the snapshot.
+//  Snapshot is owned by the server.
+static ftyinfo_t *
+s_info_snapshot (fty_info_server_t *self, bool test)
+{
+    if (test) {
+        if (!self->test_info) {
+            self->test_info = ftyinfo_test_new ();
+            self->test_info_msg = s_create_info (self->test_info);
+        }
+        return self->test_info;
+    }
+
+    uint64_t identity = localidentity_generation (localidentity_shared ());
+    if (self->info && !self->info_stale
+    &&  self->info_generation == topologyresolver_generation (self->resolver)
+    &&  self->info_identity == identity)
+        return self->info;
+
+    log_debug ("fty-info: rebuilding INFO snapshot");
+    ftyinfo_destroy (&self->info);
+    self->info = ftyinfo_new (self->resolver, self->path);
+    // resolving topology may have fetched missing parents, take generation after
+    self->info_generation = topologyresolver_generation (self->resolver);
+    self->info_identity = identity;
+    self->info_stale = false;
+
+    zmsg_t *info_msg = s_create_info (self->info);
+    if (!s_zmsg_eq (info_msg, self->info_msg)) {
+        zmsg_destroy (&self->info_msg);
+        self->info_msg = info_msg;
+        // version is time of the change in msec, so it increases across
+        // restarts too
+        self->info_version = std::max (self->info_version + 1, (uint64_t) fty_info_clock_time (self->clock));
+    }
+    else
+        zmsg_destroy (&info_msg);
+    return self->info;
+}
+
+//  --------------------------------------------------------------------------
+//  Return version of INFO (or INFO-TEST) snapshot, it increases on every change
+static uint64_t
+s_info_version (fty_info_server_t *self, bool test)
+{
+    s_info_snapshot (self, test);
+    return test ? 1 : self->info_version;
+}
+
+//  --------------------------------------------------------------------------
+//  Return encoded INFO (or INFO-TEST) snapshot: INFO/name/type/subtype/port/hash
+//  Message is owned by the server, use zmsg_dup to send it.
+static zmsg_t *
+s_info_message (fty_info_server_t *self, bool test)
+{
+    s_info_snapshot (self, test);
+    return test ? self->test_info_msg : self->info_msg;
+}
+
+//  --------------------------------------------------------------------------
+//  Return true if client accepts a message without blocking
+static bool
+s_outbox_writable (fty_info_server_t *self)
+{
+    if (self->outbox_hold)
+        return false;
+    return (zsock_events (mlm_client_msgpipe (self->client)) & ZMQ_POLLOUT) != 0;
+}
+
+//  --------------------------------------------------------------------------
+//  Hand message from outbox over to client: address/subject/timeout/content,
+//  empty address means ANNOUNCE stream. Message stays owned by the caller.
+static int
+s_outbox_deliver (fty_info_server_t *self, zmsg_t *message)
+{
+    zframe_t *address = zmsg_first (message);
+    char *subject = zframe_strdup (zmsg_next (message));
+    char *timeout = zframe_strdup (zmsg_next (message));
+    zmsg_t *content = zmsg_new ();
+    for (zframe_t *frame = zmsg_next (message); frame; frame = zmsg_next (message))
+        zmsg_addmem (content, zframe_data (frame), zframe_size (frame));
+
+    int rv;
+    if (zframe_size (address) == 0)
+        rv = mlm_client_send (self->client, subject, &content);
+    else {
+        char *recipient = zframe_strdup (address);
+        rv = mlm_client_sendto (self->client, recipient, subject, NULL,
+                (uint32_t) strtoul (timeout, NULL, 10), &content);
+        zstr_free (&recipient);
+    }
+    zmsg_destroy (&content);
+    zstr_free (&timeout);
+    zstr_free (&subject);
+    return rv;
+}
+
+//  --------------------------------------------------------------------------
+//  Schedule next flush of a non empty outbox, backing off while the client
+//  keeps refusing messages, e.g. while the broker is down
+static void
+s_outbox_backoff (fty_info_server_t *self)
+{
+    self->outbox_due = fty_info_clock_mono (self->clock) + self->outbox_backoff;
+    self->outbox_backoff = std::min (2 * self->outbox_backoff, OUTBOX_RETRY_MAX_MS);
+}
+
+//  --------------------------------------------------------------------------
+//  Send messages waiting in outbox as long as client accepts them, once the
+//  backoff is over. A message failing OUTBOX_RETRIES times is dropped.
+static void
+s_outbox_flush (fty_info_server_t *self)
+{
+    if (zlistx_size (self->outbox) == 0 || self->outbox_hold)
+        return;
+    if (self->outbox_due && fty_info_clock_mono (self->clock) < self->outbox_due)
+        return;
+    zmsg_t *message = (zmsg_t *) zlistx_first (self->outbox);
+    while (message && s_outbox_writable (self)) {
+        if (s_outbox_deliver (self, message) == 0)
+            self->outbox_sent++;
+        else
+        if (++self->outbox_attempts < OUTBOX_RETRIES) {
+            self->outbox_retried++;
+            break;
+        }
+        else {
+            log_error ("%s: message dropped after %d failed sends", self->name, OUTBOX_RETRIES);
+            self->outbox_dropped++;
+        }
+        self->outbox_attempts = 0;
+        zlistx_delete (self->outbox, zlistx_cursor (self->outbox));
+        message = (zmsg_t *) zlistx_first (self->outbox);
+    }
+    if (message)
+        s_outbox_backoff (self);
+    else {
+        self->outbox_due = 0;
+        self->outbox_backoff = OUTBOX_RETRY_MS;
+    }
+}
+
+//  --------------------------------------------------------------------------
+//  Send message to address, or publish it on ANNOUNCE stream if address is
+//  NULL. Never blocks: if client does not accept it now, message waits in
+//  outbox. Takes ownership of message.
+static void
+s_outbox_send (fty_info_server_t *self, const char *address, const char *subject,
+        uint32_t timeout, zmsg_t **content_p)
+{
+    zmsg_t *message = *content_p;
+    *content_p = NULL;
+    zmsg_pushstrf (message, "%" PRIu32, timeout);
+    zmsg_pushstr (message, subject);
+    zmsg_pushstr (message, address ? address : "");
+
+    if (zlistx_size (self->outbox) == 0 && s_outbox_writable (self)
+    &&  s_outbox_deliver (self, message) == 0) {
+        self->outbox_sent++;
+        zmsg_destroy (&message);
+        return;
+    }
+    if (zlistx_size (self->outbox) >= OUTBOX_MAX) {
+        log_warning ("%s: outbox full, oldest message dropped", self->name);
+        self->outbox_dropped++;
+        self->outbox_attempts = 0;
+        zlistx_first (self->outbox);
+        zlistx_delete (self->outbox, zlistx_cursor (self->outbox));
+    }
+    zlistx_add_end (self->outbox, message);
+    self->outbox_queued++;
+    if (!self->outbox_due)
+        s_outbox_backoff (self);
+}
+
 //  --------------------------------------------------------------------------
 //  publish INFO announcement on STREAM ANNOUNCE/ANNOUNCE-TEST
 //  subject : CREATE/UPDATE
 static void
-s_publish_announce(fty_info_server_t  * self)
+s_publish_announce(fty_info_server_t  * self, bool full)
+{
+
+    if (!self->announce_producer)
+        return;
+    zmsg_t *template_msg = s_info_message (self, self->test);
+    uint64_t hash = s_zmsg_hash (template_msg);
+    uint64_t version = s_info_version (self, self->test);
+    const char *subject;
+    zmsg_t *msg;
+
+    if (self->first_announce)
+        subject = "CREATE";
+    else
+    if (self->announce_delta && !full && self->announce_infos
+    &&  self->announce_deltas < ANNOUNCE_DELTA_MAX)
+        subject = "DELTA";
+    else
+        subject = "UPDATE";
+
+    if (streq (subject, "DELTA"))
+        msg = s_create_delta (template_msg, self->announce_infos, version, self->announce_version);
+    else {
+        msg = zmsg_dup (template_msg);
+        // consumers of deltas need version of the full snapshot too
+        if (self->announce_delta)
+            zmsg_addstrf (msg, "%" PRIu64, version);
+    }
+
+    s_outbox_send (self, NULL, subject, 0, &msg);
+    log_info("publish %s msg on ANNOUNCE STREAM", subject);
+    self->first_announce=false;
+    self->announce_hash = hash;
+    self->announce_version = version;
+    self->announce_published++;
+    self->announce_deltas = streq (subject, "DELTA") ? self->announce_deltas + 1 : 0;
+    zhash_destroy (&self->announce_infos);
+    self->announce_infos = zhash_unpack (zmsg_last (template_msg));
+    if (self->announce_interval > 0)
+        self->heartbeat_due = fty_info_clock_mono (self->clock) + self->announce_interval * 1000;
+}
+
+//  --------------------------------------------------------------------------
+//  Publish announce unless INFO is the same as the last published one
+static void
+s_publish_announce_changed (fty_info_server_t *self)
 {
+    if (!self->first_announce
+    &&  s_zmsg_hash (s_info_message (self, self->test)) == self->announce_hash) {
+        self->announce_unchanged++;
+        log_debug ("fty-info: INFO unchanged, announce dropped (published %" PRIu64
+            ", coalesced %" PRIu64 ", unchanged %" PRIu64 ")",
+            self->announce_published, self->announce_coalesced, self->announce_unchanged);
+        return;
+    }
+    s_publish_announce (self, false);
+}
 
-    if(!mlm_client_connected(self->announce_client))
+//  --------------------------------------------------------------------------
+//  Request announce triggered by an asset. Requests are coalesced over
+//  announce_window msec, so a storm of asset messages ends in one announce.
+static void
+s_announce_schedule (fty_info_server_t *self)
+{
+    if (self->announce_window <= 0) {
+        s_publish_announce_changed (self);
         return;
-    ftyinfo_t *info;
-    if (!self->test) {
-        info = ftyinfo_new (self->resolver,self->path);
     }
+    if (self->announce_due)
+        self->announce_coalesced++;
     else
-        info = ftyinfo_test_new ();
+        self->announce_due = fty_info_clock_mono (self->clock) + self->announce_window;
+}
+
+//  --------------------------------------------------------------------------
+//  Publish pending announce if its window is over
+static void
+s_announce_flush (fty_info_server_t *self)
+{
+    if (!self->announce_due || fty_info_clock_mono (self->clock) < self->announce_due)
+        return;
+    self->announce_due = 0;
+    s_publish_announce_changed (self);
+}
+
+//  --------------------------------------------------------------------------
+//  Return encoded INFO (or INFO-TEST) stamped with its version, used for
+//  HEARTBEAT and conditional INFO: INFO/name/type/subtype/port/hash/version
+//  Message is owned by the server, use zmsg_dup to send it.
+static zmsg_t *
+s_info_versioned_message (fty_info_server_t *self, bool test)
+{
+    zmsg_t *template_msg = s_info_message (self, test);
+    uint64_t version = s_info_version (self, test);
+    if (!self->versioned_msg[test] || self->versioned_version[test] != version) {
+        zmsg_destroy (&self->versioned_msg[test]);
+        self->versioned_msg[test] = zmsg_dup (template_msg);
+        zmsg_addstrf (self->versioned_msg[test], "%" PRIu64, version);
+        self->versioned_version[test] = version;
+    }
+    return self->versioned_msg[test];
+}
+
+//  --------------------------------------------------------------------------
+//  Publish HEARTBEAT if nothing was announced for announce_interval seconds,
+//  so consumers which missed CREATE do not need to poll INFO
+static void
+s_heartbeat (fty_info_server_t *self)
+{
+    if (!self->heartbeat_due || fty_info_clock_mono (self->clock) < self->heartbeat_due)
+        return;
+    self->heartbeat_due = fty_info_clock_mono (self->clock) + self->announce_interval * 1000;
+    if (!self->announce_producer)
+        return;
+
+    zmsg_t *msg = zmsg_dup (s_info_versioned_message (self, self->test));
+    s_outbox_send (self, NULL, "HEARTBEAT", 0, &msg);
+    log_debug ("publish HEARTBEAT msg on ANNOUNCE STREAM");
+    self->announce_heartbeats++;
+}
+
+//  --------------------------------------------------------------------------
+//  Return msec to wait in poller before the pending announce or heartbeat
+//  is due
+static int
+s_poll_timeout (fty_info_server_t *self)
+{
+    int64_t due = self->announce_due;
+    if (self->heartbeat_due && (!due || self->heartbeat_due < due))
+        due = self->heartbeat_due;
+    // client did not accept everything, try again once backoff is over
+    if (zlistx_size (self->outbox) > 0 && !self->outbox_hold && self->outbox_due
+    &&  (!due || self->outbox_due < due))
+        due = self->outbox_due;
+    int64_t timeout = TIMEOUT_MS;
+    if (due)
+        timeout = std::max (due - fty_info_clock_mono (self->clock), (int64_t) 0);
+    // TIMEOUT_MS waits infinitely, any deadline is sooner
+    int request_timeout = topologyresolver_timeout (self->resolver);
+    if (request_timeout >= 0 && (timeout < 0 || request_timeout < timeout))
+        timeout = request_timeout;
+    return (int) timeout;
+}
 
-    zmsg_t *msg = s_create_info (info);
+//  --------------------------------------------------------------------------
+//  Rebuild INFO snapshot, announce only if INFO really changed
+static void
+s_info_refresh (fty_info_server_t *self)
+{
+    self->info_stale = true;
+    s_info_snapshot (self, false);
+    // test mode announces INFO-TEST which does not depend on the system
+    if (!self->test)
+        s_publish_announce_changed (self);
+}
+
+//  --------------------------------------------------------------------------
+//  Watch files parsed into INFO. Directories are watched, so files which do
+//  not exist yet or are replaced by rename are noticed too.
+static void
+s_watch_init (fty_info_server_t *self)
+{
+    self->watch_fd = inotify_init1 (IN_NONBLOCK | IN_CLOEXEC);
+    if (self->watch_fd == -1) {
+        log_error ("fty-info: inotify_init1 failed: %s", strerror (errno));
+        return;
+    }
 
-    if (self->first_announce) {
-        if (mlm_client_send (self->announce_client, "CREATE", &msg) != -1) {
-            log_info("publish CREATE msg on ANNOUNCE STREAM");
-            self->first_announce=false;
+    zlistx_t *files = ftyinfo_input_files ();
+    // kernel hostname is set from this file, local identity reads it again
+    zlistx_add_end (files, strdup (HOSTNAME_FILE));
+    const char *file = (const char *) zlistx_first (files);
+    while (file) {
+        char *copy = strdup (file);
+        std::string dir = dirname (copy);
+        free (copy);
+
+        bool watched = false;
+        for (auto &it : self->watch_dirs)
+            watched = watched || (it.second == dir);
+        if (!watched) {
+            int wd = inotify_add_watch (self->watch_fd, dir.c_str (), IN_CLOSE_WRITE | IN_MOVED_TO);
+            if (wd == -1)
+                log_warning ("fty-info: cannot watch %s: %s", dir.c_str (), strerror (errno));
+            else
+                self->watch_dirs [wd] = dir;
         }
-        else
-            log_error("cant publish CREATE msg on ANNOUNCE STREAM");
-    } else {
-        if (mlm_client_send (self->announce_client, "UPDATE", &msg) != -1)
-            log_info("publish UPDATE msg on ANNOUNCE STREAM");
-        else
-            log_error("cant publish UPDATE msg on ANNOUNCE STREAM");
+        self->watch_files.insert (file);
+        file = (const char *) zlistx_next (files);
     }
-    ftyinfo_destroy (&info);
+    zlistx_destroy (&files);
 }
 
 //  --------------------------------------------------------------------------
-//  publish Linux system info on STREAM METRICS
+//  Process inotify events, rebuild INFO snapshot if any of the parsed files
+//  was written or moved in, announce only if INFO really changed
 static void
-s_publish_linuxmetrics (fty_info_server_t  * self)
+s_handle_watch (fty_info_server_t *self)
 {
-    log_debug ("s_publish_linuxmetrics");
+    char buffer [4096] __attribute__ ((aligned (__alignof__ (struct inotify_event))));
+    bool changed = false;
+    ssize_t len;
+
+    while ((len = read (self->watch_fd, buffer, sizeof (buffer))) > 0) {
+        const struct inotify_event *event;
+        for (char *ptr = buffer; ptr < buffer + len; ptr += sizeof (struct inotify_event) + event->len) {
+            event = (const struct inotify_event *) ptr;
+            if (event->len == 0)
+                continue;
+            auto dir = self->watch_dirs.find (event->wd);
+            if (dir == self->watch_dirs.end ())
+                continue;
+            std::string path = dir->second + "/" + event->name;
+            if (self->watch_files.count (path)) {
+                log_info ("fty-info: %s changed", path.c_str ());
+                if (path == HOSTNAME_FILE)
+                    localidentity_update_hostname (localidentity_shared ());
+                changed = true;
+            }
+        }
+    }
+    if (changed)
+        s_info_refresh (self);
+}
 
-    zlistx_t *info = linuxmetric_get_all
-        (self->linuxmetrics_interval,
-         self->history,
-         self->root_dir,
-         self->test);
+//  --------------------------------------------------------------------------
+//  Process address changes of local interfaces
+static void
+s_handle_identity (fty_info_server_t *self)
+{
+    if (localidentity_update (localidentity_shared ()))
+        s_info_refresh (self);
+}
 
-    int ttl = 3 * self->linuxmetrics_interval; // in seconds
+//  --------------------------------------------------------------------------
+//  tell metrics actor which rack controller the metrics belong to
+static void
+s_metrics_iname (fty_info_server_t *self)
+{
+    if (!self->metrics)
+        return;
     char *rc_iname = topologyresolver_id (self->resolver);
+    if (rc_iname && (!self->metrics_iname || !streq (rc_iname, self->metrics_iname))) {
+        zstr_sendx (self->metrics, "INAME", rc_iname, NULL);
+        zstr_free (&self->metrics_iname);
+        self->metrics_iname = rc_iname;
+    }
+    else
+        zstr_free (&rc_iname);
+}
 
-    linuxmetric_t *metric = (linuxmetric_t *) zlistx_first (info);
-    while (metric) {
-        char *value = zsys_sprintf ("%lf", metric->value);
-        log_debug ("Publishing metric %s, value %lf, unit %s", metric->type , metric->value, metric->unit);
+//  --------------------------------------------------------------------------
+//  record usec it took to handle one message or metrics cycle of a kind
+static void
+s_latency_record (fty_info_server_t *self, const char *kind, int64_t usecs)
+{
+    fty_info_histogram_t *histogram = (fty_info_histogram_t *) zhashx_lookup (self->latencies, kind);
+    if (!histogram) {
+        histogram = fty_info_histogram_new ();
+        zhashx_insert (self->latencies, kind, histogram);
+    }
+    fty_info_histogram_record (histogram, usecs);
+}
 
-        if(fty::shm::write_metric(rc_iname, metric->type, value, metric->unit, ttl) == 0) {
-            log_trace ("Metric %s published", metric->type);
+//  --------------------------------------------------------------------------
+//  create STATS reply, frame with <kind>.count, .p50, .p90, .p99 and .max
+static zmsg_t *
+s_latency_stats (fty_info_server_t *self)
+{
+    zhash_t *stats = zhash_new ();
+    zhash_autofree (stats);
+    fty_info_histogram_t *histogram = (fty_info_histogram_t *) zhashx_first (self->latencies);
+    while (histogram) {
+        std::string kind ((const char *) zhashx_cursor (self->latencies));
+        zhash_insert (stats, (kind + ".count").c_str (),
+                (void *) std::to_string (fty_info_histogram_count (histogram)).c_str ());
+        zhash_insert (stats, (kind + ".p50").c_str (),
+                (void *) std::to_string (fty_info_histogram_percentile (histogram, 50)).c_str ());
+        zhash_insert (stats, (kind + ".p90").c_str (),
+                (void *) std::to_string (fty_info_histogram_percentile (histogram, 90)).c_str ());
+        zhash_insert (stats, (kind + ".p99").c_str (),
+                (void *) std::to_string (fty_info_histogram_percentile (histogram, 99)).c_str ());
+        zhash_insert (stats, (kind + ".max").c_str (),
+                (void *) std::to_string (fty_info_histogram_max (histogram)).c_str ());
+        histogram = (fty_info_histogram_t *) zhashx_next (self->latencies);
+    }
+    zmsg_t *msg = zmsg_new ();
+    zmsg_addstr (msg, "STATS");
+    zframe_t *frame = zhash_pack (stats);
+    zmsg_append (msg, &frame);
+    zhash_destroy (&stats);
+    return msg;
+}
+
+//  --------------------------------------------------------------------------
+//  write p50 and p99 of latencies as metrics of the rack controller, they
+//  expire like Linux metrics collected with the same interval
+static void
+s_latency_publish (fty_info_server_t *self, int interval)
+{
+    const char *iname = self->metrics_iname ? self->metrics_iname : DEFAULT_RC_INAME;
+    fty_info_histogram_t *histogram = (fty_info_histogram_t *) zhashx_first (self->latencies);
+    while (histogram) {
+        const char *kind = (const char *) zhashx_cursor (self->latencies);
+        for (int percentile : {50, 99}) {
+            char *type = zsys_sprintf ("latency_p%d.%s", percentile, kind);
+            std::string value = std::to_string (fty_info_histogram_percentile (histogram, percentile));
+            if (fty::shm::write_metric (iname, type, value, "us", 3 * interval) != 0)
+                log_error ("Can't publish metric %s", type);
+            zstr_free (&type);
         }
-        else {
-            log_error ("Can't publish metric %s", metric->type);
+        histogram = (fty_info_histogram_t *) zhashx_next (self->latencies);
+    }
+}
+
+//  --------------------------------------------------------------------------
+//  handle report of metrics actor, duration of a cycle or STATS requested
+//  by LINUXMETRICSSTATS which is passed to the pipe
+static void
+s_handle_metrics (fty_info_server_t *self, zsock_t *pipe)
+{
+    char *report = NULL;
+    uint64_t first = 0, second = 0;
+    if (zsock_recv (self->metrics, "s88", &report, &first, &second) == -1 || !report)
+        return;
+    if (streq (report, "CYCLE")) {
+        s_latency_record (self, "metrics.cycle", (int64_t) first);
+        if (self->latency_metrics)
+            s_latency_publish (self, (int) second);
+    }
+    else
+    if (streq (report, "STATS"))
+        zsock_send (pipe, "88", first, second);
+    zstr_free (&report);
+}
+
+//  --------------------------------------------------------------------------
+//  process message from FTY_PROTO_ASSET stream
+void static
+s_process_stream (fty_info_server_t* self, mlm_client_t *client, zmsg_t *message)
+{
+    // decoding is expensive, drop what can't change the topology by subject
+    if (!topologyresolver_wants (self->resolver, mlm_client_subject (client))) {
+        self->assets_skipped++;
+        zmsg_destroy (&message);
+        return;
+    }
+    if (!is_fty_proto (message)){
+        zmsg_destroy (&message);
+        return;
+    }
+    fty_proto_t *bmessage = fty_proto_decode (&message);
+    if (!bmessage ) {
+        log_error ("can't decode message with subject %s, ignoring", mlm_client_subject (client));
+        zmsg_destroy (&message);
+        return;
+    }
+    self->assets_decoded++;
+    if (fty_proto_id (bmessage) != FTY_PROTO_ASSET) {
+        fty_proto_destroy (&bmessage);
+        zmsg_destroy (&message);
+        return;
+
+    }
+    if(topologyresolver_asset (self->resolver, bmessage)) {
+        s_announce_schedule (self);
+    }
+    s_metrics_iname (self);
+    if (self->rc0 && fty_info_rc0_runonce_asset (self->rc0, self->client, bmessage) != 0) {
+        log_debug ("RC-0 updated, finishing");
+        fty_info_rc0_runonce_destroy (&self->rc0);
+    }
+
+    fty_proto_destroy (&bmessage);
+    zmsg_destroy (&message);
+
+}
+
+//  --------------------------------------------------------------------------
+//  process stream message, time it took is recorded per stream
+void static
+s_handle_stream (fty_info_server_t* self, mlm_client_t *client, zmsg_t *message)
+{
+    int64_t start = zclock_usecs ();
+    char kind [128];
+    snprintf (kind, sizeof (kind), "stream.%s", mlm_client_address (client));
+    s_process_stream (self, client, message);
+    s_latency_record (self, kind, zclock_usecs () - start);
+}
+
+//  --------------------------------------------------------------------------
+//  (re)subscribe to ASSETS stream with pattern. The consumer is connected
+//  once, on the first subscription. Malamute can't drop a single pattern, so
+//  later all of them are cancelled and the new one is set on the same
+//  connection. Messages published in the round trip between both commands
+//  are not delivered, the topology is fetched from ASSET AGENT again once
+//  the new pattern is set, so an update of it missed meanwhile is recovered.
+//  return 0 on success, -1 on error
+static int
+s_assets_subscribe (fty_info_server_t *self, const char *pattern)
+{
+    int rv = 0;
+    bool resubscribe = self->assets_client != NULL;
+    if (!resubscribe) {
+        mlm_client_t *client = mlm_client_new ();
+        char *address = zsys_sprintf ("%s-assets", self->name);
+        rv = mlm_client_connect (client, self->endpoint, 1000, address);
+        zstr_free (&address);
+        if (rv == -1) {
+            log_error ("%s: can't connect ASSETS consumer to %s", self->name, self->endpoint);
+            mlm_client_destroy (&client);
+            return -1;
         }
-        linuxmetric_destroy (&metric);
-        metric = (linuxmetric_t *) zlistx_next (info);
-        zstr_free (&value);
+        self->assets_client = client;
+        if (self->poller && !self->assets_hold)
+            zpoller_add (self->poller, mlm_client_msgpipe (self->assets_client));
+    }
+    else
+        rv = mlm_client_remove_consumer (self->assets_client, FTY_PROTO_STREAM_ASSETS);
+    if (rv != -1)
+        rv = mlm_client_set_consumer (self->assets_client, FTY_PROTO_STREAM_ASSETS, pattern);
+    if (rv == -1) {
+        log_error ("%s: can't set consumer on stream '%s', '%s'",
+                self->name, FTY_PROTO_STREAM_ASSETS, pattern);
+        // subscription state is unknown, try again with the next batch
+        zstr_free (&self->assets_pattern);
+        return -1;
     }
+    zstr_free (&self->assets_pattern);
+    self->assets_pattern = strdup (pattern);
+    if (resubscribe)
+        topologyresolver_refresh (self->resolver);
+    return 0;
+}
 
-    free(rc_iname);
-    zlistx_destroy (&info);
+//  --------------------------------------------------------------------------
+//  Once the topology is resolved, nothing but rack controllers and assets in
+//  the topology passes topologyresolver_wants, so let malamute filter the
+//  rest instead of delivering it
+static void
+s_assets_narrow (fty_info_server_t *self)
+{
+    if (!self->assets_client)
+        return;
+    zlistx_t *inames = topologyresolver_inames (self->resolver);
+    if (!zlistx_size (inames)) {
+        zlistx_destroy (&inames);
+        return;
+    }
+    std::string pattern = ".*\\.rackcontroller@.*|.*@(";
+    const char *iname = (const char *) zlistx_first (inames);
+    while (iname) {
+        for (const char *p = iname; *p; p++) {
+            if (!isalnum (*p) && *p != '-' && *p != '_') {
+                // not worth escaping, inames are made of these
+                log_debug ("can't narrow ASSETS pattern for iname %s", iname);
+                zlistx_destroy (&inames);
+                return;
+            }
+        }
+        pattern += iname;
+        iname = (const char *) zlistx_next (inames);
+        pattern += iname ? "|" : ")$";
+    }
+    zlistx_destroy (&inames);
 
+    if (self->assets_pattern && pattern == self->assets_pattern)
+        return;
+    if (pattern.size () > ASSETS_PATTERN_MAX) {
+        log_debug ("narrowed ASSETS pattern '%s' is too long", pattern.c_str ());
+        return;
+    }
+    if (s_assets_subscribe (self, pattern.c_str ()) == 0)
+        log_info ("ASSETS consumer narrowed to '%s', %" PRIu64 " messages decoded, %" PRIu64 " skipped so far",
+                pattern.c_str (), self->assets_decoded, self->assets_skipped);
+}
+
+//  --------------------------------------------------------------------------
+//  process a batch of ASSETS messages ready on the consumer. The batch ends
+//  early when a mailbox request arrives, so INFO and HW_CAP never wait
+//  behind a REPUBLISH for more than one message.
+//  Assets are only cached by the resolver until the consumer is drained,
+//  then the topology is resolved once for all of them.
+static void
+s_handle_assets (fty_info_server_t *self)
+{
+    mlm_client_t *client = self->assets_client;
+    zsock_t *mailbox = mlm_client_msgpipe (self->client);
+    topologyresolver_begin (self->resolver);
+    if (!self->assets_batches++)
+        self->assets_begun = fty_info_clock_mono (self->clock);
+    for (int i = 0; i < ASSETS_BATCH; i++) {
+        if (i > 0 && ((zsock_events (mailbox) & ZMQ_POLLIN)
+                    || !(zsock_events (mlm_client_msgpipe (client)) & ZMQ_POLLIN)))
+            break;
+        zmsg_t *message = mlm_client_recv (client);
+        if (!message)
+            break;
+        if (streq (mlm_client_command (client), "STREAM DELIVER"))
+            s_handle_stream (self, client, message);
+        else
+            zmsg_destroy (&message);
+    }
+    if ((zsock_events (mlm_client_msgpipe (client)) & ZMQ_POLLIN)
+            && self->assets_batches < ASSETS_COMMIT_BATCHES
+            && fty_info_clock_mono (self->clock) - self->assets_begun < ASSETS_COMMIT_MS)
+        // more to come, keep the batch open, but not forever on a steady stream
+        return;
+    self->assets_batches = 0;
+    self->assets_begun = 0;
+    if (topologyresolver_commit (self->resolver))
+        s_announce_schedule (self);
+    s_assets_narrow (self);
 }
 
 //  --------------------------------------------------------------------------
 //  process pipe message
 //  return true means continue, false means TERM
 bool static
-s_handle_pipe(fty_info_server_t* self,zmsg_t *message)
+s_handle_pipe(fty_info_server_t* self, zsock_t *pipe, zmsg_t *message)
 {
     if (!message)
         return true;
@@ -294,13 +1139,15 @@ s_handle_pipe(fty_info_server_t* self,zmsg_t *message)
         char *endpoint = zmsg_popstr (message);
 
         if (endpoint) {
-            if (!self->test)
-                topologyresolver_set_endpoint (self->resolver, endpoint);
             self->endpoint = strdup(endpoint);
             log_debug ("fty-info: CONNECT: %s/%s", self->endpoint, self->name);
             int rv = mlm_client_connect (self->client, self->endpoint, 1000, self->name);
             if (rv == -1)
                 log_error("mlm_client_connect failed\n");
+            else
+            if (!self->test)
+                // ASSET_DETAIL replies are passed to resolver by actor loop
+                topologyresolver_set_client (self->resolver, self->client);
 
         }
         zstr_free (&endpoint);
@@ -310,7 +1157,9 @@ s_handle_pipe(fty_info_server_t* self,zmsg_t *message)
         char *path = zmsg_popstr (message);
 
         if (path) {
+            zstr_free (&self->path);
             self->path = strdup(path);
+            self->info_stale = true;
             log_debug ("fty-info: PATH: %s", self->path);
         }
         zstr_free (&path);
@@ -319,10 +1168,18 @@ s_handle_pipe(fty_info_server_t* self,zmsg_t *message)
     if (streq (command, "CONSUMER")) {
         char* stream = zmsg_popstr (message);
         char* pattern = zmsg_popstr (message);
-        int rv = mlm_client_set_consumer (self->client, stream, pattern);
-        if (rv == -1)
-            log_error ("%s: can't set consumer on stream '%s', '%s'",
-                    self->name, stream, pattern);
+        if (streq (stream, FTY_PROTO_STREAM_ASSETS)) {
+            // own consumer, so the pattern can be narrowed later without
+            // affecting other streams
+            s_assets_subscribe (self, pattern);
+            s_assets_narrow (self);
+        }
+        else {
+            int rv = mlm_client_set_consumer (self->client, stream, pattern);
+            if (rv == -1)
+                log_error ("%s: can't set consumer on stream '%s', '%s'",
+                        self->name, stream, pattern);
+        }
         zstr_free (&pattern);
         zstr_free (&stream);
     }
@@ -331,29 +1188,25 @@ s_handle_pipe(fty_info_server_t* self,zmsg_t *message)
         char* stream = zmsg_popstr (message);
         if (streq (stream, "ANNOUNCE-TEST") || streq (stream, "ANNOUNCE")) {
             self->test = streq(stream,"ANNOUNCE-TEST");
+            zstr_sendx (self->metrics, "TEST", self->test ? "1" : "0", NULL);
             if (!self->test) {
                 zmsg_t *republish = zmsg_new ();
-                int rv = mlm_client_sendto (self->client, FTY_ASSET_AGENT, "REPUBLISH", NULL, 5000, &republish);
-                if ( rv != 0) {
-                     log_error ("%s: cannot send REPUBLISH message", self->name);
-                     zmsg_destroy (&republish);
-                }
+                s_outbox_send (self, FTY_ASSET_AGENT, "REPUBLISH", 5000, &republish);
             }
-            int rv = mlm_client_connect (self->announce_client, self->endpoint, 1000, "fty_info_announce");
-            if (rv == -1)
-                    log_error("fty_info_announce : mlm_client_connect failed\n");
-            rv = mlm_client_set_producer (self->announce_client, stream);
+            int rv = mlm_client_set_producer (self->client, stream);
             if (rv == -1)
                 log_error ("%s: can't set producer on stream '%s'",
                         self->name, stream);
-            else
+            else {
+                self->announce_producer = true;
                 //do the first announce
-                s_publish_announce(self);
+                s_publish_announce(self, true);
+            }
         }
         else if (streq (stream, "METRICS-TEST")) {
             // publish the first metrics
             // we need to keep this approach for testing purpose
-            s_publish_linuxmetrics (self);
+            zstr_sendx (self->metrics, "PUBLISH", NULL);
         }
         else {
             int rv = mlm_client_set_producer (self->client, stream);
@@ -363,26 +1216,124 @@ s_handle_pipe(fty_info_server_t* self,zmsg_t *message)
         }
         zstr_free (&stream);
     }
+    else if (streq (command, "ANNOUNCEWINDOW")) {
+        char *window = zmsg_popstr (message);
+        if (window) {
+            self->announce_window = (int) strtol (window, NULL, 10);
+            log_info ("Announces triggered by assets will be coalesced over %d ms", self->announce_window);
+        }
+        zstr_free (&window);
+    }
+    else if (streq (command, "OUTBOXHOLD")) {
+        // testing only, keeps messages in outbox as if client was busy
+        char *hold = zmsg_popstr (message);
+        self->outbox_hold = hold && streq (hold, "1");
+        zstr_free (&hold);
+        // released messages go out now
+        self->outbox_due = 0;
+        s_outbox_flush (self);
+    }
+    else if (streq (command, "ASSETSHOLD")) {
+        // testing only, ASSETS messages pile up as if the loop was busy
+        char *hold = zmsg_popstr (message);
+        bool assets_hold = hold && streq (hold, "1");
+        if (self->assets_client && assets_hold != self->assets_hold) {
+            if (assets_hold)
+                zpoller_remove (self->poller, mlm_client_msgpipe (self->assets_client));
+            else
+                zpoller_add (self->poller, mlm_client_msgpipe (self->assets_client));
+        }
+        self->assets_hold = assets_hold;
+        zstr_free (&hold);
+    }
+    else if (streq (command, "OUTBOXSTATS")) {
+        zsock_send (pipe, "88888", (uint64_t) zlistx_size (self->outbox),
+            self->outbox_sent, self->outbox_queued, self->outbox_retried, self->outbox_dropped);
+    }
+    else if (streq (command, "ASSETSTATS")) {
+        zsock_send (pipe, "88", self->assets_decoded, self->assets_skipped);
+    }
+    else if (streq (command, "RC0RUNONCE")) {
+        // fill data about rackcontroller-0 from the first UPDATE of it
+        if (!self->rc0)
+            self->rc0 = fty_info_rc0_runonce_new (self->name);
+    }
+    else if (streq (command, "ANNOUNCESTATS")) {
+        zsock_send (pipe, "8888", self->announce_published,
+            self->announce_coalesced, self->announce_unchanged, self->announce_heartbeats);
+    }
     else if (streq (command, "LINUXMETRICSINTERVAL")) {
         char *interval = zmsg_popstr (message);
         log_info ("Will be publishing metrics each %s seconds", interval);
-        self->linuxmetrics_interval = (int) strtol (interval, NULL, 10);
+        zstr_sendx (self->metrics, "INTERVAL", interval, NULL);
         zstr_free (&interval);
     }
     else if (streq (command, "ROOT_DIR")) {
         char *root_dir = zmsg_popstr (message);
         log_info ("Will be using %s as root dir for finding out Linux metrics", root_dir);
-        self->root_dir.assign (root_dir);
+        zstr_sendx (self->metrics, "ROOT_DIR", root_dir, NULL);
         zstr_free (&root_dir);
     }
     else if (streq (command, "TEST")) {
         self->test = true;
+        zstr_sendx (self->metrics, "TEST", "1", NULL);
     }
     else if (streq (command, "ANNOUNCE")) {
-        s_publish_announce (self);
+        s_publish_announce (self, true);
+    }
+    else if (streq (command, "ANNOUNCEINTERVAL")) {
+        char *interval = zmsg_popstr (message);
+        if (interval) {
+            self->announce_interval = (int) strtol (interval, NULL, 10);
+            log_info ("Will be publishing HEARTBEAT after %d seconds of silence", self->announce_interval);
+            if (self->announce_interval <= 0)
+                self->heartbeat_due = 0;
+            else
+            if (!self->first_announce)
+                self->heartbeat_due = fty_info_clock_mono (self->clock) + self->announce_interval * 1000;
+        }
+        zstr_free (&interval);
+    }
+    else if (streq (command, "ANNOUNCEDELTA")) {
+        char *delta = zmsg_popstr (message);
+        self->announce_delta = delta && (streq (delta, "1") || streq (delta, "true"));
+        log_info ("DELTA announces are %s", self->announce_delta ? "enabled" : "disabled");
+        zstr_free (&delta);
     }
     else if (streq (command, "LINUXMETRICS")) {
-        s_publish_linuxmetrics (self);
+        zstr_sendx (self->metrics, "PUBLISH", NULL);
+    }
+    else if (streq (command, "VIRTUALCLOCK")) {
+        // testing only, time moves only by CLOCKADVANCE from now on
+        if (!self->clock) {
+            self->clock = fty_info_clock_new (true);
+            zsock_send (self->metrics, "sp", "CLOCK", self->clock);
+            topologyresolver_set_clock (self->resolver, self->clock);
+        }
+    }
+    else if (streq (command, "CLOCKADVANCE")) {
+        char *msec = zmsg_popstr (message);
+        if (msec && self->clock) {
+            fty_info_clock_advance (self->clock, strtoll (msec, NULL, 10));
+            zstr_sendx (self->metrics, "TICK", NULL);
+        }
+        zstr_free (&msec);
+    }
+    else if (streq (command, "LINUXMETRICSSTATS")) {
+        // reply comes after reports of cycles, s_handle_metrics passes it on
+        zstr_sendx (self->metrics, "STATS", NULL);
+    }
+    else if (streq (command, "LATENCYMETRICS")) {
+        char *enabled = zmsg_popstr (message);
+        self->latency_metrics = enabled && (streq (enabled, "1") || streq (enabled, "true"));
+        log_info ("Latency metrics are %s", self->latency_metrics ? "enabled" : "disabled");
+        zstr_free (&enabled);
+    }
+    else if (streq (command, "LINUXMETRICSDELAY")) {
+        // testing only, makes every collection slower
+        char *delay = zmsg_popstr (message);
+        zstr_sendx (self->metrics, "DELAY", delay ? delay : "0", NULL);
+        zstr_free (&delay);
     }
     else if (streq (command, "CONFIG")) {
         self->hw_cap_path = zmsg_popstr (message);
@@ -490,41 +1441,12 @@ out:
 }
 
 
-//  --------------------------------------------------------------------------
-//  process message from FTY_PROTO_ASSET stream
-void static
-s_handle_stream (fty_info_server_t* self, zmsg_t *message)
-{
-    if (!is_fty_proto (message)){
-        zmsg_destroy (&message);
-        return;
-    }
-    fty_proto_t *bmessage = fty_proto_decode (&message);
-    if (!bmessage ) {
-        log_error ("can't decode message with subject %s, ignoring", mlm_client_subject (self->client));
-        zmsg_destroy (&message);
-        return;
-    }
-    if (fty_proto_id (bmessage) != FTY_PROTO_ASSET) {
-        fty_proto_destroy (&bmessage);
-        zmsg_destroy (&message);
-        return;
-
-    }
-    if(topologyresolver_asset (self->resolver, bmessage)) {
-        s_publish_announce(self);
-    }
-
-    fty_proto_destroy (&bmessage);
-    zmsg_destroy (&message);
-
-}
-
 //  --------------------------------------------------------------------------
 //  process message from MAILBOX DELIVER
 void static
 s_handle_mailbox(fty_info_server_t* self,zmsg_t *message)
 {
+    int64_t start = zclock_usecs ();
     char *command = zmsg_popstr (message);
     if (!command) {
         zmsg_destroy (&message);
@@ -534,25 +1456,30 @@ s_handle_mailbox(fty_info_server_t* self,zmsg_t *message)
 
     char *zuuid = zmsg_popstr (message);
     zmsg_t *reply = NULL;
+    // unknown commands share one histogram, there can be any number of them
+    const char *kind = "unknown";
 
     //we assume all request command are MAILBOX DELIVER, and with any subject"
-    if (streq (command, "INFO")) {
-        ftyinfo_t *info = ftyinfo_new (self->resolver,self->path);
-
-        reply = s_create_info (info);
-        zmsg_pushstrf (reply, "%s", zuuid);
-        ftyinfo_destroy (&info);
-    }
-    else
-    if (streq (command, "INFO-TEST")) {
-        ftyinfo_t *info = ftyinfo_test_new ();
-
-        reply = s_create_info (info);
+    if (streq (command, "INFO") || streq (command, "INFO-TEST")) {
+        bool test = streq (command, "INFO-TEST");
+        kind = command;
+        char *known_version = zmsg_popstr (message);
+        if (!known_version)
+            reply = zmsg_dup (s_info_message (self, test));
+        else
+        if (streq (known_version, std::to_string (s_info_version (self, test)).c_str ())) {
+            // conditional request, client has the current snapshot
+            reply = zmsg_new ();
+            zmsg_addstr (reply, "NOT-MODIFIED");
+        }
+        else
+            reply = zmsg_dup (s_info_versioned_message (self, test));
         zmsg_pushstrf (reply, "%s", zuuid);
-        ftyinfo_destroy (&info);
+        zstr_free (&known_version);
     }
     else
     if (streq (command, "HW_CAP")) {
+        kind = command;
         char *type = zmsg_popstr (message);
         if (type)
             reply = s_hw_cap (self, type, zuuid);
@@ -566,7 +1493,14 @@ s_handle_mailbox(fty_info_server_t* self,zmsg_t *message)
         zstr_free (&type);
     }
     else
+    if (streq (command, "STATS")) {
+        kind = command;
+        reply = s_latency_stats (self);
+        zmsg_pushstrf (reply, "%s", zuuid);
+    }
+    else
     if (streq (command, "ERROR")) {
+        kind = command;
         // Don't reply to ERROR messages
         log_warning ("%s: Received ERROR command from '%s', ignoring", self->name, mlm_client_sender (self->client));
     }
@@ -581,17 +1515,12 @@ s_handle_mailbox(fty_info_server_t* self,zmsg_t *message)
         zmsg_addstr (reply, "unexpected command");
     }
 
-    if (reply) {
-        int rv = mlm_client_sendto (self->client,
-                                    mlm_client_sender (self->client),
-                                    "info",
-                                    NULL,
-                                    1000,
-                                    &reply);
-        if (rv != 0)
-            log_error ("s_handle_mailbox: failed to send reply to %s ", mlm_client_sender (self->client));
-    }
+    if (reply)
+        s_outbox_send (self, mlm_client_sender (self->client), "info", 1000, &reply);
 
+    char name [64];
+    snprintf (name, sizeof (name), "mailbox.%s", kind);
+    s_latency_record (self, name, zclock_usecs () - start);
     zstr_free (&zuuid);
     zstr_free (&command);
     zmsg_destroy (&message);
@@ -612,8 +1541,21 @@ fty_info_server (zsock_t *pipe, void *args)
     }
 
     fty_info_server_t *self = info_server_new (name);
+    self->metrics = zactor_new (fty_info_metrics, NULL);
+    zstr_sendx (self->metrics, "REPORT", "1", NULL);
+    s_metrics_iname (self);
+    // zpoller reports ready readers in order they were added, so pipe and
+    // mailbox always go before ASSETS consumer added later
     zpoller_t *poller = zpoller_new (pipe, mlm_client_msgpipe (self->client), NULL);
     assert (poller);
+    self->poller = poller;
+    s_watch_init (self);
+    if (self->watch_fd >= 0)
+        zpoller_add (poller, &self->watch_fd);
+    self->identity_fd = localidentity_fd (localidentity_shared ());
+    if (self->identity_fd >= 0)
+        zpoller_add (poller, &self->identity_fd);
+    zpoller_add (poller, self->metrics);
 
     zsock_signal (pipe, 0);
     log_info ("fty-info: Started");
@@ -621,38 +1563,89 @@ fty_info_server (zsock_t *pipe, void *args)
 
     while (!zsys_interrupted)
     {
-        void *which = zpoller_wait (poller, TIMEOUT_MS);
+        void *which = zpoller_wait (poller, s_poll_timeout (self));
         if (which == NULL) {
             if (zpoller_terminated (poller) || zsys_interrupted) {
                 break;
             }
         }
+        s_outbox_flush (self);
+        topologyresolver_expire (self->resolver);
+        s_announce_flush (self);
+        s_heartbeat (self);
         if (which == pipe) {
             log_trace ("which == pipe");
-            if(!s_handle_pipe(self,zmsg_recv (pipe)))
+            if(!s_handle_pipe(self, pipe, zmsg_recv (pipe)))
                 break;//TERM
             else continue;
         }
         else
+        if (which == &self->watch_fd) {
+            s_handle_watch (self);
+        }
+        else
+        if (which == &self->identity_fd) {
+            s_handle_identity (self);
+        }
+        else
+        if (which == self->metrics) {
+            s_handle_metrics (self, pipe);
+        }
+        else
         if (which == mlm_client_msgpipe (self->client)) {
             zmsg_t *message = mlm_client_recv (self->client);
             if (!message)
                 continue;
             const char *command = mlm_client_command (self->client);
             if (streq (command, "STREAM DELIVER")) {
-                s_handle_stream (self, message);
+                s_handle_stream (self, self->client, message);
             }
             else
             if (streq (command, "MAILBOX DELIVER")) {
-                s_handle_mailbox (self, message);
+                // the client is shared, replies of asset agent are not requests
+                const char *subject = mlm_client_subject (self->client);
+                if (streq (subject, "ASSET_DETAIL")) {
+                    if (topologyresolver_reply (self->resolver, &message))
+                        s_announce_schedule (self);
+                }
+                else
+                if (streq (subject, "ASSET_MANIPULATION"))
+                    // reply to update of rackcontroller-0, nothing to do
+                    zmsg_destroy (&message);
+                else
+                    s_handle_mailbox (self, message);
             }
         }
+        else
+        if (self->assets_client && which == mlm_client_msgpipe (self->assets_client)) {
+            s_handle_assets (self);
+        }
     }
 
+    self->poller = NULL;
     zpoller_destroy (&poller);
     info_server_destroy(&self);
 }
 
+//  --------------------------------------------------------------------------
+//  Collect Linux metrics over 1 s without the metrics actor, return them
+//  as type -> value
+
+static std::map<std::string, double>
+s_test_linuxmetrics (zhashx_t *history, std::string &root_dir)
+{
+    std::map<std::string, double> values;
+    zlistx_t *info = linuxmetric_get_all (1, history, NULL, root_dir, true);
+    linuxmetric_t *metric = (linuxmetric_t *) zlistx_first (info);
+    while (metric) {
+        values [metric->type] = metric->value;
+        linuxmetric_destroy (&metric);
+        metric = (linuxmetric_t *) zlistx_next (info);
+    }
+    zlistx_destroy (&info);
+    return values;
+}
+
 //  --------------------------------------------------------------------------
 //  Self test of this class
 
@@ -682,9 +1675,13 @@ fty_info_server_test (bool verbose)
     mlm_client_connect (client, endpoint, 1000, "fty_info_server_test");
 
 
+    // accepted license file is watched by the server, keep it in test dir
+    setenv ("DATADIR", SELFTEST_DIR_RW, 1);
     zactor_t *info_server = zactor_new (fty_info_server, (void*) "fty-info");
     zstr_sendx (info_server, "TEST", NULL);
     zstr_sendx (info_server, "PATH", DEFAULT_PATH, NULL);
+    // no HEARTBEAT among replies, test #16 enables it
+    zstr_sendx (info_server, "ANNOUNCEINTERVAL", "0", NULL);
     zstr_sendx (info_server, "CONNECT", endpoint, NULL);
     zstr_sendx (info_server, "CONSUMER", FTY_PROTO_STREAM_ASSETS, ".*", NULL);
 	zclock_sleep (1000);
@@ -1118,10 +2115,16 @@ fty_info_server_test (bool verbose)
 
         std::string root_dir = str_SELFTEST_DIR_RO + "/data/";
         zstr_sendx (info_server, "ROOT_DIR", root_dir.c_str (), NULL);
+        // from now on time moves only when the test says so, a collection
+        // on the interval boundary must not overwrite the rates checked here
+        zstr_sendx (info_server, "VIRTUALCLOCK", NULL);
         zstr_sendx (info_server, "LINUXMETRICSINTERVAL", "30", NULL);
+        // publish the first metrics explicitly, stats come after it is done
         zstr_sendx (info_server, "PRODUCER", "METRICS-TEST", NULL);
-        
-        zclock_sleep (1000);
+        uint64_t collections, missed;
+        zstr_sendx (info_server, "LINUXMETRICSSTATS", NULL);
+        int rv = zsock_recv (info_server, "88", &collections, &missed);
+        assert (rv == 0 && collections == 1);
 
         zhashx_t *metrics = zhashx_new ();
         zhashx_set_destructor (metrics, (void (*)(void**)) fty_proto_destroy);
@@ -1140,8 +2143,19 @@ fty_info_server_test (bool verbose)
             }
             state = (const char *) zhashx_next (interfaces);
         }
+        // LAN1 reports its speed, so we have rx and tx utilization for it
+        number_metrics += 2;
+        // NET_RX, NET_TX, TIMER softirqs and interrupts per CPU and their
+        // skew ratios are not published until there is a previous sample
+        // frequency of 2 cpufreq policies, core and package throttle count
+        number_metrics += 2 + 2;
+        // oom_kill, pswpin, pswpout, pgmajfault and allocstall rates are
+        // not published until there is a previous sample
+        // we have written bytes of each block device, 2 more for eMMC,
+        // write rate needs a previous sample; loop0 and stacked dm-0 are not
+        // physical devices
+        number_metrics += 1 + 2;
         {
-          zclock_sleep (1000);
           fty::shm::shmMetrics results;
           fty::shm::read_metrics(".*", ".*", results);
           assert(results.size() == number_metrics);
@@ -1247,10 +2261,106 @@ fty_info_server_test (bool verbose)
                 else
                     assert (0 == atoi (fty_proto_value (metric)));
                 zstr_free (&tx_error_ratio);
+
+                // 33333 Bps on 100 Mbps link
+                char *tx_utilization = zsys_sprintf (UTILIZATION_TEMPLATE, "tx", iface);
+                metric = (fty_proto_t *) zhashx_lookup (metrics, tx_utilization);
+                if (streq (iface, "LAN1")) {
+                    assert (metric);
+                    assert (3 == atoi (fty_proto_value (metric)));
+                }
+                else
+                    assert (metric == NULL);
+                zstr_free (&tx_utilization);
             }
             state = (const char *) zhashx_next (interfaces);
         }
 
+        assert (zhashx_lookup (metrics, "net_rx_softirq.cpu0") == NULL);
+        assert (zhashx_lookup (metrics, "interrupts_skew") == NULL);
+
+        char *frequency = zsys_sprintf (CPU_FREQUENCY_TEMPLATE, "policy0");
+        metric = (fty_proto_t *) zhashx_lookup (metrics, frequency);
+        assert (metric);
+        assert (1200 == atoi (fty_proto_value (metric)));
+        zstr_free (&frequency);
+        metric = (fty_proto_t *) zhashx_lookup (metrics, LINUXMETRIC_CPU_THROTTLE_COUNT);
+        assert (metric);
+        assert (8 == atoi (fty_proto_value (metric)));
+        // cpu0 and cpu1 share package 0, cpu2 is on package 1
+        metric = (fty_proto_t *) zhashx_lookup (metrics, LINUXMETRIC_CPU_PACKAGE_THROTTLE_COUNT);
+        assert (metric);
+        assert (7 + 4 == atoi (fty_proto_value (metric)));
+
+        // totals since boot are not rates
+        assert (zhashx_lookup (metrics, LINUXMETRIC_OOM_KILL_RATE) == NULL);
+        assert (zhashx_lookup (metrics, LINUXMETRIC_MAJOR_FAULT_RATE) == NULL);
+
+        char *written_bytes = zsys_sprintf (WRITTEN_BYTES_TEMPLATE, "mmcblk0");
+        assert (zhashx_lookup (metrics, written_bytes));
+        metric = (fty_proto_t *) zhashx_lookup (metrics, written_bytes);
+        assert (10240 == atoi (fty_proto_value (metric)));
+        zstr_free (&written_bytes);
+
+        char *write_rate = zsys_sprintf (WRITE_RATE_TEMPLATE, "mmcblk0");
+        assert (!zhashx_lookup (metrics, write_rate));
+
+        char *life_time = zsys_sprintf (EMMC_LIFE_TIME_TEMPLATE, "mmcblk0");
+        assert (zhashx_lookup (metrics, life_time));
+        metric = (fty_proto_t *) zhashx_lookup (metrics, life_time);
+        assert (20 == atoi (fty_proto_value (metric)));
+        zstr_free (&life_time);
+
+        char *pre_eol = zsys_sprintf (EMMC_PRE_EOL_TEMPLATE, "mmcblk0");
+        assert (zhashx_lookup (metrics, pre_eol));
+        metric = (fty_proto_t *) zhashx_lookup (metrics, pre_eol);
+        assert (1 == atoi (fty_proto_value (metric)));
+        zstr_free (&pre_eol);
+
+        char *loop_bytes = zsys_sprintf (WRITTEN_BYTES_TEMPLATE, "loop0");
+        assert (!zhashx_lookup (metrics, loop_bytes));
+        zstr_free (&loop_bytes);
+
+        // rates once history is seeded, previous sample with all counters
+        // zeroed makes them equal to the counters over 1 s
+        zhashx_t *history = zhashx_new ();
+        zhashx_set_destructor (history, (czmq_destructor *) zstr_free);
+        std::map<std::string, double> values = s_test_linuxmetrics (history, root_dir);
+        assert (values.count (LINUXMETRIC_OOM_KILL_RATE) == 0);
+        assert (values.count (write_rate) == 0);
+        assert (values.count ("net_rx_softirq.cpu0") == 0);
+        assert (values.count ("net_rx_softirq_skew") == 0);
+        for (double *last = (double *) zhashx_first (history); last;
+                last = (double *) zhashx_next (history))
+            *last = 0;
+        values = s_test_linuxmetrics (history, root_dir);
+        assert (values [LINUXMETRIC_OOM_KILL_RATE] == 3);
+        assert (values [LINUXMETRIC_SWAP_IN_RATE] == 300);
+        assert (values [LINUXMETRIC_SWAP_OUT_RATE] == 600);
+        assert (values [LINUXMETRIC_MAJOR_FAULT_RATE] == 3000);
+        assert (values [LINUXMETRIC_ALLOC_STALL_RATE] == 60 + 30);
+        assert (values ["net_rx_softirq.cpu0"] == 60000);
+        assert (values ["net_rx_softirq_skew"] == 2);
+        // CPU1 is offline, the second column is CPU2
+        assert (values.count ("timer_softirq.cpu1") == 0);
+        assert (values ["timer_softirq.cpu2"] == 90000);
+        assert (values ["interrupts.cpu2"] == 60000);
+        assert (fabs (values ["interrupts_skew"] - 4.0 / 3) < 0.01);
+        // 20 sectors of 512 B per second
+        assert (values [write_rate] == 20 * 512 * 86400);
+        // device attached again, its counter starts from zero
+        char *written_key = zsys_sprintf ("%s_written_%s", DISK_HISTORY_PREFIX, "mmcblk0");
+        double *written_last = (double *) zhashx_lookup (history, written_key);
+        assert (written_last);
+        *written_last = 2 * 10240;
+        values = s_test_linuxmetrics (history, root_dir);
+        assert (values.count (write_rate) == 0);
+        values = s_test_linuxmetrics (history, root_dir);
+        assert (values [write_rate] == 0);
+        zstr_free (&written_key);
+        zstr_free (&write_rate);
+        zhashx_destroy (&history);
+
         zhashx_destroy (&interfaces);
         zhashx_destroy (&metrics);
         log_info ("fty-info-test:Test #7: OK");
@@ -1358,6 +2468,783 @@ fty_info_server_test (bool verbose)
         log_info ("OK\n");
     }
 
+    {
+        // TEST #11: INFO from snapshot vs. rebuilding INFO for every request
+        log_info ("fty-info-test:Test #11: INFO snapshot benchmark");
+        fty_info_server_t *bench = info_server_new ((char *) "fty-info-bench");
+        bench->path = strdup (DEFAULT_PATH);
+        const int iterations = 200;
+
+        int64_t start = zclock_usecs ();
+        for (int i = 0; i < iterations; i++) {
+            ftyinfo_t *info = ftyinfo_new (bench->resolver, bench->path);
+            zmsg_t *reply = s_create_info (info);
+            zmsg_destroy (&reply);
+            ftyinfo_destroy (&info);
+        }
+        int64_t rebuild_usecs = zclock_usecs () - start;
+
+        start = zclock_usecs ();
+        for (int i = 0; i < iterations; i++) {
+            zmsg_t *reply = zmsg_dup (s_info_message (bench, false));
+            zmsg_pushstr (reply, "uuid");
+            zmsg_destroy (&reply);
+        }
+        int64_t snapshot_usecs = zclock_usecs () - start;
+
+        log_info ("fty-info-test: INFO requests per second: %.0f rebuilding, %.0f from snapshot",
+            iterations * 1000000.0 / (rebuild_usecs ? rebuild_usecs : 1),
+            iterations * 1000000.0 / (snapshot_usecs ? snapshot_usecs : 1));
+
+        // nothing changed, snapshot and its encoding are reused
+        ftyinfo_t *snapshot = s_info_snapshot (bench, false);
+        uint64_t version = bench->info_version;
+        assert (snapshot == s_info_snapshot (bench, false));
+        assert (version == bench->info_version);
+        assert (zmsg_size (s_info_message (bench, false)) == 6);
+
+        info_server_destroy (&bench);
+        log_info ("fty-info-test:Test #11: OK");
+    }
+
+    {
+        // TEST #12: INFO is rebuilt when accepted license file is written
+        log_info ("fty-info-test:Test #12: license file watch");
+        std::string license = std::string (SELFTEST_DIR_RW) + "/license";
+        {
+            std::ofstream f (license);
+            f << "1.0\n1500000000\n";
+        }
+        zclock_sleep (500);
+
+        zmsg_t *request = zmsg_new ();
+        zmsg_addstr (request, "INFO");
+        zmsg_addstr (request, "uuid-license");
+        mlm_client_sendto (client, "fty-info", "INFO", NULL, 1000, &request);
+
+        zmsg_t *recv = mlm_client_recv (client);
+        assert (zmsg_size (recv) == 7);
+        char *zuuid_reply = zmsg_popstr (recv);
+        assert (streq (zuuid_reply, "uuid-license"));
+        zframe_t *frame_infos = zmsg_last (recv);
+        zhash_t *infos = zhash_unpack (frame_infos);
+        char *install_date = (char *) zhash_lookup (infos, INFO_INSTALL_DATE);
+        assert (install_date && streq (install_date, "2017-07-14T02:40:00Z"));
+
+        zhash_destroy (&infos);
+        zstr_free (&zuuid_reply);
+        zmsg_destroy (&recv);
+        unlink (license.c_str ());
+        unsetenv ("DATADIR");
+        log_info ("fty-info-test:Test #12: OK");
+    }
+
+    {
+        // TEST #13: streaming extraction of release details, compared with
+        // cxxtools deserialization
+        log_info ("fty-info-test:Test #13: release details extraction benchmark");
+        std::string file = std::string (SELFTEST_DIR_RO) + "/data/etc/release-details.json";
+        const char *keys[] = {"uuid", "hardware-vendor", "hardware-serial-number",
+            "hardware-catalog-number", "hardware-part-number", "osimage-name", NULL};
+        const int iterations = 1000;
+
+        int64_t start = zclock_usecs ();
+        std::string dom_values [6];
+        for (int i = 0; i < iterations; i++) {
+            cxxtools::SerializationInfo si;
+            std::ifstream f (file);
+            std::string json_string (std::istreambuf_iterator<char>(f), {});
+            std::stringstream s (json_string);
+            cxxtools::JsonDeserializer json (s);
+            json.deserialize (si);
+            for (int k = 0; k < 6; k++)
+                si.getMember ("release-details").getMember (keys[k]) >>= dom_values[k];
+        }
+        int64_t dom_usecs = zclock_usecs () - start;
+
+        start = zclock_usecs ();
+        char *values [6];
+        for (int i = 0; i < iterations; i++) {
+            int rv = ftyinfo_json_extract (file.c_str (), "release-details", keys, values);
+            assert (rv == 0);
+            for (int k = 0; k < 6; k++) {
+                assert (values[k] && dom_values[k] == values[k]);
+                zstr_free (&values[k]);
+            }
+        }
+        int64_t stream_usecs = zclock_usecs () - start;
+
+        log_info ("fty-info-test: release details parsed in %.1f us with cxxtools, %.1f us streaming",
+            (double) dom_usecs / iterations, (double) stream_usecs / iterations);
+
+        const char *branding_keys[] = {"uuid", "release-details", "missing", NULL};
+        char *branding [3];
+        assert (ftyinfo_json_extract (file.c_str (), NULL, branding_keys, branding) == 0);
+        assert (branding[0] && streq (branding[0], "top-level member is not used"));
+        assert (branding[1] == NULL);
+        assert (branding[2] == NULL);
+        zstr_free (&branding[0]);
+
+        const char *text_keys[] = {"manufacturer", "description", "installation-date", NULL};
+        char *text [3];
+        assert (ftyinfo_json_extract (file.c_str (), "release-details", text_keys, text) == 0);
+        assert (streq (text[0], "Eaton \xc3\x89lectrique \xf0\x9f\x94\x8c"));
+        assert (streq (text[1], "Rack controller\n\"42ity\" / IPM"));
+        assert (streq (text[2], "1589100000"));
+        for (int k = 0; k < 3; k++)
+            zstr_free (&text[k]);
+
+        assert (ftyinfo_json_extract ("/nonexistent/release-details.json", "release-details", keys, values) == -1);
+        for (int k = 0; k < 6; k++)
+            assert (values[k] == NULL);
+        log_info ("fty-info-test:Test #13: OK");
+    }
+
+    {
+        // TEST #14: announces triggered by an asset storm are coalesced and
+        // dropped when INFO did not change
+        log_info ("fty-info-test:Test #14: announce coalescing");
+        fty_info_server_t *storm = info_server_new ((char *) "fty-info-storm");
+        storm->test = true;
+        storm->clock = fty_info_clock_new (true);
+        storm->announce_window = 50;
+        for (int i = 0; i < 100; i++)
+            s_announce_schedule (storm);
+        assert (storm->announce_coalesced == 99);
+        assert (storm->announce_due && s_poll_timeout (storm) <= 50);
+
+        // window is not over yet
+        s_announce_flush (storm);
+        assert (storm->announce_due);
+
+        // pretend the same INFO-TEST was published already
+        fty_info_clock_advance (storm->clock, 60);
+        storm->first_announce = false;
+        storm->announce_hash = s_zmsg_hash (s_info_message (storm, true));
+        s_announce_flush (storm);
+        assert (!storm->announce_due);
+        assert (storm->announce_unchanged == 1);
+        assert (storm->announce_published == 0);
+        assert (s_poll_timeout (storm) == TIMEOUT_MS);
+        info_server_destroy (&storm);
+
+        // counters of the running server, first announce of test #6 counted
+        uint64_t published, coalesced, unchanged, heartbeats;
+        zstr_sendx (info_server, "ANNOUNCESTATS", NULL);
+        int rv = zsock_recv (info_server, "8888", &published, &coalesced, &unchanged, &heartbeats);
+        assert (rv == 0);
+        assert (published >= 1);
+        log_info ("fty-info-test:Test #14: OK");
+    }
+
+    {
+        // TEST #15: DELTA announce carries only changed keys
+        log_info ("fty-info-test:Test #15: DELTA announce");
+        zhash_t *base = zhash_new ();
+        zhash_insert (base, INFO_NAME, (void *) "old name");
+        zhash_insert (base, INFO_LOCATION, (void *) "DC1");
+        zhash_insert (base, INFO_CONTACT, (void *) "admin");
+        zhash_t *infos = zhash_new ();
+        zhash_insert (infos, INFO_NAME, (void *) "new name");
+        zhash_insert (infos, INFO_LOCATION, (void *) "DC1");
+        zhash_insert (infos, INFO_UUID, (void *) TST_UUID);
+
+        zmsg_t *info_msg = zmsg_new ();
+        zmsg_addstr (info_msg, FTY_INFO_CMD);
+        zmsg_addstr (info_msg, "IPC (ce7c523e)");
+        zmsg_addstr (info_msg, SRV_TYPE);
+        zmsg_addstr (info_msg, SRV_STYPE);
+        zmsg_addstr (info_msg, SRV_PORT);
+        zframe_t *frame = zhash_pack (infos);
+        zmsg_append (info_msg, &frame);
+
+        zmsg_t *delta = s_create_delta (info_msg, base, 8, 7);
+        assert (zmsg_size (delta) == 9);
+        char *cmd = zmsg_popstr (delta);
+        assert (streq (cmd, FTY_INFO_CMD));
+        for (int i = 0; i < 4; i++) {
+            char *srv = zmsg_popstr (delta);
+            zstr_free (&srv);
+        }
+        char *version = zmsg_popstr (delta);
+        char *base_version = zmsg_popstr (delta);
+        assert (streq (version, "8") && streq (base_version, "7"));
+
+        frame = zmsg_pop (delta);
+        zhash_t *changed = zhash_unpack (frame);
+        zframe_destroy (&frame);
+        assert (zhash_size (changed) == 2);
+        assert (streq ((char *) zhash_lookup (changed, INFO_NAME), "new name"));
+        assert (streq ((char *) zhash_lookup (changed, INFO_UUID), TST_UUID));
+
+        frame = zmsg_pop (delta);
+        zhash_t *removed = zhash_unpack (frame);
+        zframe_destroy (&frame);
+        assert (zhash_size (removed) == 1);
+        assert (zhash_lookup (removed, INFO_CONTACT));
+
+        zhash_destroy (&removed);
+        zhash_destroy (&changed);
+        zstr_free (&base_version);
+        zstr_free (&version);
+        zstr_free (&cmd);
+        zmsg_destroy (&delta);
+        zmsg_destroy (&info_msg);
+        zhash_destroy (&infos);
+        zhash_destroy (&base);
+        log_info ("fty-info-test:Test #15: OK");
+    }
+
+    {
+        // TEST #16: HEARTBEAT is the same encoded INFO stamped with version
+        log_info ("fty-info-test:Test #16: HEARTBEAT announce");
+        // virtual clock of test #7, time moves only when the test says so
+        zstr_sendx (info_server, "ANNOUNCEINTERVAL", "1", NULL);
+        zstr_sendx (info_server, "CLOCKADVANCE", "1000", NULL);
+        zmsg_t *recv = mlm_client_recv (client);
+        assert (recv);
+        assert (streq (mlm_client_command (client), "STREAM DELIVER"));
+        assert (streq (mlm_client_subject (client), "HEARTBEAT"));
+        assert (zmsg_size (recv) == 7);
+        char *cmd = zmsg_popstr (recv);
+        assert (cmd && streq (cmd, FTY_INFO_CMD));
+        zframe_t *frame_version = zmsg_last (recv);
+        char *stamp = zframe_strdup (frame_version);
+        assert (stamp && streq (stamp, "1"));
+        zstr_free (&stamp);
+        zstr_free (&cmd);
+        zmsg_destroy (&recv);
+        zstr_sendx (info_server, "ANNOUNCEINTERVAL", "0", NULL);
+
+        // heartbeat encoding is reused until INFO changes
+        fty_info_server_t *beat = info_server_new ((char *) "fty-info-beat");
+        beat->test = true;
+        zmsg_t *heartbeat = s_info_versioned_message (beat, true);
+        assert (heartbeat == s_info_versioned_message (beat, true));
+        assert (zmsg_size (heartbeat) == 7);
+        info_server_destroy (&beat);
+
+        // version of real INFO only increases: heartbeat is stamped again
+        // after every change, with the time of the change or, within the
+        // same msec, with the previous version plus one
+        fty_info_server_t *real = info_server_new ((char *) "fty-info-real");
+        real->clock = fty_info_clock_new (true);
+        uint64_t versions [3];
+        for (int i = 0; i < 3; i++) {
+            zstr_free (&real->path);
+            real->path = zsys_sprintf ("/api/v%d", i + 1);
+            real->info_stale = true;
+            if (i == 2)
+                fty_info_clock_advance (real->clock, 1000);
+            heartbeat = s_info_versioned_message (real, false);
+            assert (zmsg_size (heartbeat) == 7);
+            // INFO/name/type/subtype/port/infos/version
+            zframe_t *frame = zmsg_first (heartbeat);
+            for (int j = 0; j < 5; j++)
+                frame = zmsg_next (heartbeat);
+            zhash_t *infos = zhash_unpack (frame);
+            char *path = (char *) zhash_lookup (infos, INFO_REST_PATH);
+            assert (path && streq (path, real->path));
+            zhash_destroy (&infos);
+            stamp = zframe_strdup (zmsg_last (heartbeat));
+            versions [i] = strtoull (stamp, NULL, 10);
+            zstr_free (&stamp);
+        }
+        assert (versions [0] == (uint64_t) fty_info_clock_time (real->clock) - 1000);
+        assert (versions [1] == versions [0] + 1);
+        assert (versions [2] == (uint64_t) fty_info_clock_time (real->clock));
+        // unchanged INFO keeps its version
+        real->info_stale = true;
+        heartbeat = s_info_versioned_message (real, false);
+        stamp = zframe_strdup (zmsg_last (heartbeat));
+        assert (strtoull (stamp, NULL, 10) == versions [2]);
+        zstr_free (&stamp);
+        info_server_destroy (&real);
+        log_info ("fty-info-test:Test #16: OK");
+    }
+
+    {
+        // TEST #17: conditional INFO-TEST and INFO
+        log_info ("fty-info-test:Test #17: conditional INFO");
+        const char *versions[] = {"0", "1"};
+        for (int i = 0; i < 2; i++) {
+            zmsg_t *request = zmsg_new ();
+            zmsg_addstr (request, "INFO-TEST");
+            zmsg_addstr (request, "uuid-conditional");
+            zmsg_addstr (request, versions[i]);
+            mlm_client_sendto (client, "fty-info", "INFO", NULL, 1000, &request);
+
+            zmsg_t *recv = mlm_client_recv (client);
+            assert (recv);
+            char *zuuid_reply = zmsg_popstr (recv);
+            assert (zuuid_reply && streq (zuuid_reply, "uuid-conditional"));
+            char *cmd = zmsg_popstr (recv);
+            if (i == 0) {
+                // unknown version, full INFO stamped with the current one
+                assert (cmd && streq (cmd, FTY_INFO_CMD));
+                assert (zmsg_size (recv) == 6);
+                char *version = zframe_strdup (zmsg_last (recv));
+                assert (streq (version, "1"));
+                zstr_free (&version);
+            }
+            else {
+                assert (cmd && streq (cmd, "NOT-MODIFIED"));
+                assert (zmsg_size (recv) == 0);
+            }
+            zstr_free (&cmd);
+            zstr_free (&zuuid_reply);
+            zmsg_destroy (&recv);
+        }
+
+        // real INFO: known version is NOT-MODIFIED until an input changes,
+        // then the full INFO comes with a greater version
+        uint64_t version = 0;
+        for (int i = 0; i < 3; i++) {
+            if (i == 2) {
+                // rename this RC
+                uint64_t decoded, skipped, decoded_before;
+                zstr_sendx (info_server, "ASSETSTATS", NULL);
+                int rv = zsock_recv (info_server, "88", &decoded_before, &skipped);
+                assert (rv == 0);
+                zhash_t *aux = zhash_new ();
+                zhash_t *ext = zhash_new ();
+                zhash_autofree (aux);
+                zhash_autofree (ext);
+                zhash_update (aux, "type", (void *) "device");
+                zhash_update (aux, "subtype", (void *) "rackcontroller");
+                zhash_update (aux, "parent", (void *) TST_PARENT2_INAME);
+                zhash_update (ext, "name", (void *) "MyIPC renamed");
+                zhash_update (ext, "ip.1", (void *) "127.0.0.1");
+                zmsg_t *msg = fty_proto_encode_asset (aux, TST_INAME, FTY_PROTO_ASSET_OP_UPDATE, ext);
+                rv = mlm_client_send (asset_generator, "device.rackcontroller@" TST_INAME, &msg);
+                assert (rv == 0);
+                zhash_destroy (&aux);
+                zhash_destroy (&ext);
+                // topology is resolved before ASSETSTATS can tell it was decoded
+                for (decoded = decoded_before; decoded == decoded_before; ) {
+                    zclock_sleep (50);
+                    zstr_sendx (info_server, "ASSETSTATS", NULL);
+                    rv = zsock_recv (info_server, "88", &decoded, &skipped);
+                    assert (rv == 0);
+                }
+            }
+            zmsg_t *request = zmsg_new ();
+            zmsg_addstr (request, "INFO");
+            zmsg_addstr (request, "uuid-conditional");
+            zmsg_addstrf (request, "%" PRIu64, version);
+            mlm_client_sendto (client, "fty-info", "INFO", NULL, 1000, &request);
+
+            zmsg_t *recv = mlm_client_recv (client);
+            assert (recv);
+            char *zuuid_reply = zmsg_popstr (recv);
+            assert (zuuid_reply && streq (zuuid_reply, "uuid-conditional"));
+            char *cmd = zmsg_popstr (recv);
+            if (i == 1) {
+                assert (cmd && streq (cmd, "NOT-MODIFIED"));
+                assert (zmsg_size (recv) == 0);
+            }
+            else {
+                assert (cmd && streq (cmd, FTY_INFO_CMD));
+                assert (zmsg_size (recv) == 6);
+                char *stamp = zframe_strdup (zmsg_last (recv));
+                uint64_t current = strtoull (stamp, NULL, 10);
+                zstr_free (&stamp);
+                assert (current > version);
+                version = current;
+                if (i == 2) {
+                    zframe_t *frame_infos = zmsg_first (recv);
+                    for (int j = 0; j < 4; j++)
+                        frame_infos = zmsg_next (recv);
+                    zhash_t *infos = zhash_unpack (frame_infos);
+                    char *name = (char *) zhash_lookup (infos, INFO_NAME);
+                    assert (name && streq (name, "MyIPC renamed"));
+                    zhash_destroy (&infos);
+                }
+            }
+            zstr_free (&cmd);
+            zstr_free (&zuuid_reply);
+            zmsg_destroy (&recv);
+        }
+        log_info ("fty-info-test:Test #17: OK");
+    }
+
+    {
+        // TEST #18: ASSETS messages not about the topology are dropped
+        // undecoded, the consumer is narrowed once the topology is resolved
+        log_info ("fty-info-test:Test #18: ASSETS subject filtering");
+        mlm_client_t *asset_agent = mlm_client_new ();
+        mlm_client_connect (asset_agent, endpoint, 1000, "asset-agent");
+        uint64_t decoded, skipped, decoded2, skipped2;
+        zstr_sendx (info_server, "ASSETSTATS", NULL);
+        int rv = zsock_recv (info_server, "88", &decoded, &skipped);
+        assert (rv == 0);
+
+        // unrelated asset, me placed in a rack, the rack
+        const char *subjects[] = {
+            "device.ups@ups-18",
+            "device.rackcontroller@" TST_INAME,
+            "rack.N_A@rack-18",
+            // narrowed consumer does not even get the unrelated one
+            "device.ups@ups-18",
+            "rack.N_A@rack-18"
+        };
+        for (int i = 0; i < 5; i++) {
+            zhash_t *aux = zhash_new ();
+            zhash_t *ext = zhash_new ();
+            zhash_autofree (aux);
+            zhash_autofree (ext);
+            if (i == 1) {
+                zhash_update (aux, "type", (void *) "device");
+                zhash_update (aux, "subtype", (void *) "rackcontroller");
+                zhash_update (aux, "parent_name.1", (void *) "rack-18");
+                zhash_update (ext, "name", (void *) TST_NAME);
+                zhash_update (ext, "ip.1", (void *) "127.0.0.1");
+            }
+            zmsg_t *msg = fty_proto_encode_asset (
+                    aux,
+                    strchr (subjects[i], '@') + 1,
+                    FTY_PROTO_ASSET_OP_UPDATE,
+                    ext);
+            rv = mlm_client_send (asset_generator, subjects[i], &msg);
+            assert (rv == 0);
+            zhash_destroy (&aux);
+            zhash_destroy (&ext);
+
+            if (i == 2) {
+                zclock_sleep (500);
+                zstr_sendx (info_server, "ASSETSTATS", NULL);
+                rv = zsock_recv (info_server, "88", &decoded2, &skipped2);
+                assert (rv == 0);
+                assert (decoded2 == decoded + 2);
+                assert (skipped2 == skipped + 1);
+            }
+        }
+        zclock_sleep (500);
+        zstr_sendx (info_server, "ASSETSTATS", NULL);
+        rv = zsock_recv (info_server, "88", &decoded, &skipped);
+        assert (rv == 0);
+        assert (decoded == decoded2 + 1);
+        assert (skipped == skipped2);
+
+        // updates missed while the consumer was narrowed are recovered by
+        // asking for the whole topology again
+        zpoller_t *poller = zpoller_new (mlm_client_msgpipe (asset_agent), NULL);
+        bool refreshed = false;
+        while (!refreshed && zpoller_wait (poller, 2000)) {
+            zmsg_t *recv = mlm_client_recv (asset_agent);
+            // missing rack may have been asked for before it was published
+            if (streq (mlm_client_subject (asset_agent), "ASSET_DETAIL")
+                    && zmsg_size (recv) == 4) {
+                char *command = zmsg_popstr (recv);
+                char *uuid = zmsg_popstr (recv);
+                char *me = zmsg_popstr (recv);
+                char *parent = zmsg_popstr (recv);
+                assert (streq (command, "GET"));
+                refreshed = streq (me, TST_INAME) && streq (parent, "rack-18");
+                zstr_free (&parent);
+                zstr_free (&me);
+                zstr_free (&uuid);
+                zstr_free (&command);
+            }
+            zmsg_destroy (&recv);
+        }
+        assert (refreshed);
+        zpoller_destroy (&poller);
+        mlm_client_destroy (&asset_agent);
+        log_info ("fty-info-test:Test #18: OK");
+    }
+
+    {
+        // TEST #19: INFO latency does not depend on Linux metrics collection
+        log_info ("fty-info-test:Test #19: INFO latency with slow metrics");
+        uint64_t collections, missed, collections_before, missed_before;
+        zstr_sendx (info_server, "LINUXMETRICSSTATS", NULL);
+        int rv = zsock_recv (info_server, "88", &collections_before, &missed_before);
+        assert (rv == 0);
+        // keep collector busy for about 5 seconds, stats are replied only
+        // after the last queued collection is done
+        const int runs = 10;
+        zstr_sendx (info_server, "LINUXMETRICSDELAY", "500", NULL);
+        for (int i = 0; i < runs; i++)
+            zstr_sendx (info_server, "LINUXMETRICS", NULL);
+        zstr_sendx (info_server, "LINUXMETRICSSTATS", NULL);
+
+        const int requests = 100;
+        std::vector<int64_t> latencies;
+        for (int i = 0; i < requests; i++) {
+            int64_t start = zclock_usecs ();
+            zmsg_t *request = zmsg_new ();
+            zmsg_addstr (request, "INFO");
+            zmsg_addstr (request, "uuid-latency");
+            mlm_client_sendto (client, "fty-info", "INFO", NULL, 1000, &request);
+            zmsg_t *recv = mlm_client_recv (client);
+            latencies.push_back (zclock_usecs () - start);
+            assert (recv && zmsg_size (recv) == 7);
+            zmsg_destroy (&recv);
+        }
+        // all requests were answered while collections were still queued,
+        // none of them waited for the collector
+        assert (!(zsock_events (info_server) & ZMQ_POLLIN));
+        rv = zsock_recv (info_server, "88", &collections, &missed);
+        assert (rv == 0);
+        assert (collections == collections_before + runs);
+        std::sort (latencies.begin (), latencies.end ());
+        // wall clock bounds fail under valgrind or on a loaded machine,
+        // so the numbers are only logged
+        log_info ("fty-info-test:Test #19: INFO p50 %" PRIi64 " us, p99 %" PRIi64 " us while collecting",
+                latencies [requests / 2 - 1], latencies [requests * 99 / 100 - 1]);
+        zstr_sendx (info_server, "LINUXMETRICSDELAY", "0", NULL);
+        log_info ("fty-info-test:Test #19: OK");
+    }
+
+    {
+        // TEST #20: INFO is answered promptly during an ASSETS flood
+        log_info ("fty-info-test:Test #20: INFO latency during ASSETS flood");
+        uint64_t decoded, skipped, decoded_before, skipped_before;
+        zstr_sendx (info_server, "ASSETSTATS", NULL);
+        int rv = zsock_recv (info_server, "88", &decoded_before, &skipped_before);
+        assert (rv == 0);
+        // the whole flood is waiting before the first request
+        zstr_sendx (info_server, "ASSETSHOLD", "1", NULL);
+        // other rack controllers pass any subject filter and get decoded
+        const int flood = 10000;
+        for (int i = 0; i < flood; i++) {
+            zhash_t *aux = zhash_new ();
+            zhash_t *ext = zhash_new ();
+            zhash_autofree (aux);
+            zhash_autofree (ext);
+            zhash_update (aux, "type", (void *) "device");
+            zhash_update (aux, "subtype", (void *) "rackcontroller");
+            char *iname = zsys_sprintf ("rackcontroller-%d", 1000 + i);
+            char *subject = zsys_sprintf ("device.rackcontroller@%s", iname);
+            zmsg_t *msg = fty_proto_encode_asset (aux, iname, FTY_PROTO_ASSET_OP_UPDATE, ext);
+            rv = mlm_client_send (asset_generator, subject, &msg);
+            assert (rv == 0);
+            zstr_free (&subject);
+            zstr_free (&iname);
+            zhash_destroy (&aux);
+            zhash_destroy (&ext);
+        }
+        zstr_sendx (info_server, "ASSETSHOLD", "0", NULL);
+
+        const int requests = 20;
+        std::vector<int64_t> latencies;
+        for (int i = 0; i < requests; i++) {
+            int64_t start = zclock_usecs ();
+            zmsg_t *request = zmsg_new ();
+            zmsg_addstr (request, "INFO");
+            zmsg_addstr (request, "uuid-flood");
+            mlm_client_sendto (client, "fty-info", "INFO", NULL, 1000, &request);
+            zmsg_t *recv = mlm_client_recv (client);
+            latencies.push_back (zclock_usecs () - start);
+            assert (recv && zmsg_size (recv) == 7);
+            zmsg_destroy (&recv);
+        }
+        std::sort (latencies.begin (), latencies.end ());
+        log_info ("fty-info-test:Test #20: INFO p50 %" PRIi64 " us, max %" PRIi64 " us during flood",
+                latencies [requests / 2 - 1], latencies [requests - 1]);
+        // at most one batch of ASSETS messages is in the way of a request,
+        // so all of them are answered long before the flood is processed
+        zstr_sendx (info_server, "ASSETSTATS", NULL);
+        rv = zsock_recv (info_server, "88", &decoded, &skipped);
+        assert (rv == 0);
+        uint64_t decoded_replied = decoded;
+        // let the flood be processed before next tests, the broker may
+        // have dropped some of it while the consumer was held
+        uint64_t decoded_last = 0;
+        while (decoded != decoded_last) {
+            decoded_last = decoded;
+            zclock_sleep (100);
+            zstr_sendx (info_server, "ASSETSTATS", NULL);
+            rv = zsock_recv (info_server, "88", &decoded, &skipped);
+            assert (rv == 0);
+        }
+        assert (decoded_replied < decoded && decoded <= decoded_before + flood);
+        log_info ("fty-info-test:Test #20: OK");
+    }
+
+    {
+        // TEST #21: rackcontroller-0 is filled in over the server connection
+        log_info ("fty-info-test:Test #21: RC0RUNONCE");
+        mlm_client_t *asset_agent = mlm_client_new ();
+        mlm_client_connect (asset_agent, endpoint, 1000, "asset-agent");
+        zstr_sendx (info_server, "RC0RUNONCE", NULL);
+
+        zhash_t *aux = zhash_new ();
+        zhash_t *ext = zhash_new ();
+        zhash_autofree (aux);
+        zhash_autofree (ext);
+        zhash_update (aux, "type", (void *) "device");
+        zhash_update (aux, "subtype", (void *) "rackcontroller");
+        zmsg_t *msg = fty_proto_encode_asset (aux, "rackcontroller-0", FTY_PROTO_ASSET_OP_UPDATE, ext);
+        int rv = mlm_client_send (asset_generator, "device.rackcontroller@rackcontroller-0", &msg);
+        assert (rv == 0);
+        zhash_destroy (&aux);
+        zhash_destroy (&ext);
+
+        zpoller_t *poller = zpoller_new (mlm_client_msgpipe (asset_agent), NULL);
+        zmsg_t *recv = NULL;
+        // ASSET_DETAIL requests of the server may be still waiting there
+        do {
+            zmsg_destroy (&recv);
+            void *which = zpoller_wait (poller, 2000);
+            assert (which == mlm_client_msgpipe (asset_agent));
+            recv = mlm_client_recv (asset_agent);
+        } while (streq (mlm_client_subject (asset_agent), "ASSET_DETAIL"));
+        assert (streq (mlm_client_subject (asset_agent), "ASSET_MANIPULATION"));
+        char *access = zmsg_popstr (recv);
+        assert (streq (access, "READONLY") || streq (access, "READWRITE"));
+        zstr_free (&access);
+        zmsg_destroy (&recv);
+        zpoller_destroy (&poller);
+        mlm_client_destroy (&asset_agent);
+        log_info ("fty-info-test:Test #21: OK");
+    }
+
+    {
+        // TEST #22: replies wait in outbox while client does not accept them
+        log_info ("fty-info-test:Test #22: outbox");
+        uint64_t waiting, sent, queued, retried, dropped;
+        zstr_sendx (info_server, "OUTBOXSTATS", NULL);
+        int rv = zsock_recv (info_server, "88888", &waiting, &sent, &queued, &retried, &dropped);
+        assert (rv == 0);
+        uint64_t sent_before = sent;
+        uint64_t queued_before = queued;
+
+        zstr_sendx (info_server, "OUTBOXHOLD", "1", NULL);
+        const int requests = 10;
+        for (int i = 0; i < requests; i++) {
+            zmsg_t *request = zmsg_new ();
+            zmsg_addstr (request, "INFO");
+            zmsg_addstr (request, "uuid-outbox");
+            mlm_client_sendto (client, "fty-info", "INFO", NULL, 1000, &request);
+        }
+        // requests are served, replies stay in outbox
+        zpoller_t *poller = zpoller_new (mlm_client_msgpipe (client), NULL);
+        void *which = zpoller_wait (poller, 200);
+        assert (which == NULL);
+        zstr_sendx (info_server, "OUTBOXSTATS", NULL);
+        rv = zsock_recv (info_server, "88888", &waiting, &sent, &queued, &retried, &dropped);
+        assert (rv == 0);
+        // announces and heartbeats may wait there too
+        assert (waiting >= requests);
+        assert (queued >= queued_before + requests);
+
+        zstr_sendx (info_server, "OUTBOXHOLD", "0", NULL);
+        for (int i = 0; i < requests; i++) {
+            zmsg_t *recv = mlm_client_recv (client);
+            assert (recv && zmsg_size (recv) == 7);
+            char *zuuid = zmsg_popstr (recv);
+            assert (streq (zuuid, "uuid-outbox"));
+            zstr_free (&zuuid);
+            zmsg_destroy (&recv);
+        }
+        zstr_sendx (info_server, "OUTBOXSTATS", NULL);
+        rv = zsock_recv (info_server, "88888", &waiting, &sent, &queued, &retried, &dropped);
+        assert (rv == 0);
+        assert (waiting == 0);
+        assert (sent >= sent_before + requests);
+        assert (dropped == 0);
+        zpoller_destroy (&poller);
+
+        // no busy polling while client keeps refusing messages
+        fty_info_server_t *refused = info_server_new ((char *) "fty-info-refused");
+        refused->clock = fty_info_clock_new (true);
+        zlistx_add_end (refused->outbox, zmsg_new ());
+        s_outbox_backoff (refused);
+        assert (s_poll_timeout (refused) == OUTBOX_RETRY_MS);
+        s_outbox_backoff (refused);
+        assert (s_poll_timeout (refused) == 2 * OUTBOX_RETRY_MS);
+        for (int i = 0; i < 20; i++)
+            s_outbox_backoff (refused);
+        assert (s_poll_timeout (refused) == OUTBOX_RETRY_MAX_MS);
+        info_server_destroy (&refused);
+        log_info ("fty-info-test:Test #22: OK");
+    }
+
+    {
+        // TEST #23: metrics scheduled on the virtual clock of test #7
+        log_info ("fty-info-test:Test #23: virtual clock");
+        uint64_t collections, missed, collections_before, missed_before;
+        zstr_sendx (info_server, "LINUXMETRICSINTERVAL", "1", NULL);
+        zstr_sendx (info_server, "LINUXMETRICSSTATS", NULL);
+        int rv = zsock_recv (info_server, "88", &collections_before, &missed_before);
+        assert (rv == 0);
+        const int cycles = 100;
+        int64_t start = zclock_usecs ();
+        for (int i = 0; i < cycles; i++)
+            zstr_sendx (info_server, "CLOCKADVANCE", "1000", NULL);
+        zstr_sendx (info_server, "LINUXMETRICSSTATS", NULL);
+        rv = zsock_recv (info_server, "88", &collections, &missed);
+        assert (rv == 0);
+        // metrics actor may see several advances at once and skip them
+        assert (collections > collections_before);
+        assert (collections + missed == collections_before + missed_before + cycles);
+        log_info ("fty-info-test:Test #23: %d virtual seconds in %" PRIi64 " us",
+                cycles, zclock_usecs () - start);
+        zstr_sendx (info_server, "LINUXMETRICSINTERVAL", "0", NULL);
+        log_info ("fty-info-test:Test #23: OK");
+    }
+
+    {
+        // TEST #24: latencies of requests, stream messages and metrics cycles
+        log_info ("fty-info-test:Test #24: STATS");
+        const int requests = 10;
+        const char *commands [] = {"INFO-TEST", "WRONG", "STATS"};
+        zmsg_t *recv = NULL;
+        for (int i = 0; i < requests + 2; i++) {
+            const char *command = commands [i < requests ? 0 : i - requests + 1];
+            zmsg_t *request = zmsg_new ();
+            zmsg_addstr (request, command);
+            zmsg_addstr (request, "uuid-stats");
+            mlm_client_sendto (client, "fty-info", command, NULL, 1000, &request);
+            // virtual clock of test #23 may have let a HEARTBEAT out
+            do {
+                zmsg_destroy (&recv);
+                recv = mlm_client_recv (client);
+                assert (recv);
+            } while (!streq (mlm_client_command (client), "MAILBOX DELIVER"));
+        }
+        assert (zmsg_size (recv) == 3);
+        char *zuuid = zmsg_popstr (recv);
+        assert (streq (zuuid, "uuid-stats"));
+        char *cmd = zmsg_popstr (recv);
+        assert (streq (cmd, "STATS"));
+        zframe_t *frame = zmsg_pop (recv);
+        zhash_t *stats = zhash_unpack (frame);
+        assert (stats);
+        assert (atoi ((char *) zhash_lookup (stats, "mailbox.INFO-TEST.count")) == requests);
+        int64_t p50 = atoll ((char *) zhash_lookup (stats, "mailbox.INFO-TEST.p50"));
+        int64_t p99 = atoll ((char *) zhash_lookup (stats, "mailbox.INFO-TEST.p99"));
+        int64_t max = atoll ((char *) zhash_lookup (stats, "mailbox.INFO-TEST.max"));
+        assert (p50 <= p99 && p99 <= max);
+        // tests above flooded ASSETS and collected metrics
+        assert (zhash_lookup (stats, "stream.ASSETS.p99"));
+        assert (zhash_lookup (stats, "metrics.cycle.p99"));
+        assert (zhash_lookup (stats, "mailbox.unknown.count"));
+        log_info ("fty-info-test:Test #24: INFO-TEST p50 %" PRIi64 " us, p99 %" PRIi64 " us",
+                p50, p99);
+        zhash_destroy (&stats);
+        zframe_destroy (&frame);
+        zstr_free (&cmd);
+        zstr_free (&zuuid);
+        zmsg_destroy (&recv);
+
+        // percentiles are published with metrics when enabled
+        zstr_sendx (info_server, "LATENCYMETRICS", "true", NULL);
+        zstr_sendx (info_server, "LINUXMETRICS", NULL);
+        // stats are passed on after the cycle was reported
+        uint64_t collections, missed;
+        zstr_sendx (info_server, "LINUXMETRICSSTATS", NULL);
+        int rv = zsock_recv (info_server, "88", &collections, &missed);
+        assert (rv == 0);
+        fty::shm::shmMetrics results;
+        fty::shm::read_metrics (".*", "latency_p99\\.mailbox\\.INFO-TEST", results);
+        assert (results.size () == 1);
+        zstr_sendx (info_server, "LATENCYMETRICS", "false", NULL);
+        log_info ("fty-info-test:Test #24: OK");
+    }
+
     mlm_client_destroy (&asset_generator);
     //  @end
 
@@ -28,7 +28,6 @@
 
 #include "fty_info_classes.h"
 
-#include <cxxtools/jsondeserializer.h>
 #include <istream>
 #include <fstream>
 #include <set>
@@ -87,88 +86,316 @@ s_get_installation_date (
 static const char* RELEASE_DETAILS = "/etc/release-details.json";
 static const char* BRANDING_INFO = "/etc/etn-ipm2-branding.conf";
 
-static cxxtools::SerializationInfo*
-s_load_release_details()
+// maximal nesting of JSON objects and arrays
+#define JSON_MAX_DEPTH 64
+
+// pull reader of a JSON file, c is the current character
+typedef struct {
+    FILE *file;
+    int c;
+    int depth;
+} json_reader_t;
+
+static inline void
+s_json_next (json_reader_t *r)
 {
-    cxxtools::SerializationInfo *si = new cxxtools::SerializationInfo();
-    try {
-        std::ifstream f(RELEASE_DETAILS);
-        std::string json_string (std::istreambuf_iterator<char>(f), {});
-        std::stringstream s(json_string);
-        cxxtools::JsonDeserializer json(s);
-        json.deserialize (*si);
-        log_info("fty-info:load %s OK", RELEASE_DETAILS);
+    r->c = getc_unlocked (r->file);
+}
+
+static inline void
+s_json_whitespace (json_reader_t *r)
+{
+    while (r->c == ' ' || r->c == '\t' || r->c == '\n' || r->c == '\r')
+        s_json_next (r);
+}
+
+static void
+s_utf8_append (std::string *out, unsigned code)
+{
+    if (code < 0x80)
+        *out += (char) code;
+    else
+    if (code < 0x800) {
+        *out += (char) (0xC0 | (code >> 6));
+        *out += (char) (0x80 | (code & 0x3F));
     }
-    catch (const std::exception& e) {
-        log_error ("Error while parsing JSON: %s", e.what ());
+    else
+    if (code < 0x10000) {
+        *out += (char) (0xE0 | (code >> 12));
+        *out += (char) (0x80 | ((code >> 6) & 0x3F));
+        *out += (char) (0x80 | (code & 0x3F));
+    }
+    else {
+        *out += (char) (0xF0 | (code >> 18));
+        *out += (char) (0x80 | ((code >> 12) & 0x3F));
+        *out += (char) (0x80 | ((code >> 6) & 0x3F));
+        *out += (char) (0x80 | (code & 0x3F));
     }
-    return si;
 }
 
-static char*
-s_get_release_details
-    (cxxtools::SerializationInfo *si,
-     const char *key,
-     const char * dfl)
+// read 4 hex digits following \u, stop on the last one
+static bool
+s_json_hex4 (json_reader_t *r, unsigned *code)
 {
-    std::string value;
-    try {
-        si->getMember("release-details").getMember(key) >>= value;
+    *code = 0;
+    for (int i = 0; i < 4; i++) {
+        s_json_next (r);
+        if (r->c >= '0' && r->c <= '9')
+            *code = *code * 16 + (r->c - '0');
+        else
+        if (r->c >= 'a' && r->c <= 'f')
+            *code = *code * 16 + (r->c - 'a' + 10);
+        else
+        if (r->c >= 'A' && r->c <= 'F')
+            *code = *code * 16 + (r->c - 'A' + 10);
+        else
+            return false;
     }
-    catch (const std::exception& e) {
-        log_info ("Problem with getting %s in JSON: %s", key, e.what ());
-        if (dfl) {
-            return strdup(dfl);
-        } else {
-            return NULL;
+    return true;
+}
+
+// read string starting at '"', store it unescaped to out unless NULL
+static bool
+s_json_string (json_reader_t *r, std::string *out)
+{
+    while (true) {
+        s_json_next (r);
+        if (r->c == EOF || (r->c >= 0 && r->c < 0x20))
+            return false;
+        if (r->c == '"') {
+            s_json_next (r);
+            return true;
+        }
+        if (r->c != '\\') {
+            if (out)
+                *out += (char) r->c;
+            continue;
+        }
+        s_json_next (r);
+        char c;
+        switch (r->c) {
+            case '"':  c = '"';  break;
+            case '\\': c = '\\'; break;
+            case '/':  c = '/';  break;
+            case 'b':  c = '\b'; break;
+            case 'f':  c = '\f'; break;
+            case 'n':  c = '\n'; break;
+            case 'r':  c = '\r'; break;
+            case 't':  c = '\t'; break;
+            case 'u': {
+                unsigned code;
+                if (!s_json_hex4 (r, &code))
+                    return false;
+                if (code >= 0xD800 && code < 0xDC00) {
+                    // high surrogate, low one must follow
+                    unsigned low;
+                    s_json_next (r);
+                    if (r->c != '\\')
+                        return false;
+                    s_json_next (r);
+                    if (r->c != 'u' || !s_json_hex4 (r, &low) || low < 0xDC00 || low >= 0xE000)
+                        return false;
+                    code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                }
+                if (out)
+                    s_utf8_append (out, code);
+                continue;
+            }
+            default:
+                return false;
         }
+        if (out)
+            *out += c;
+    }
+}
+
+// read string, number, true, false or null, store its text to out unless
+// NULL (null is stored as empty string)
+static bool
+s_json_scalar (json_reader_t *r, std::string *out)
+{
+    if (r->c == '"')
+        return s_json_string (r, out);
+
+    std::string token;
+    while ((r->c >= '0' && r->c <= '9') || (r->c >= 'a' && r->c <= 'z') ||
+           (r->c >= 'A' && r->c <= 'Z') || r->c == '-' || r->c == '+' || r->c == '.') {
+        token += (char) r->c;
+        s_json_next (r);
     }
-    if (value.empty () && dfl) {
-	    return strdup (dfl);
+    if (token == "null") {
+        if (out)
+            out->clear ();
+        return true;
     }
-    return strdup(value.c_str());
+    if (token != "true" && token != "false" &&
+        (token.empty () || (token[0] != '-' && (token[0] < '0' || token[0] > '9'))))
+        return false;
+    if (out)
+        *out = token;
+    return true;
 }
 
-static cxxtools::SerializationInfo*
-s_load_branding_info()
+// skip any value
+static bool
+s_json_skip (json_reader_t *r)
 {
-    cxxtools::SerializationInfo *si = new cxxtools::SerializationInfo();
-    try {
-        std::ifstream f(BRANDING_INFO);
-        std::string json_string (std::istreambuf_iterator<char>(f), {});
-        std::stringstream s(json_string);
-        cxxtools::JsonDeserializer json(s);
-        json.deserialize (*si);
-        log_info("fty-info:load %s OK", BRANDING_INFO);
+    if (r->c != '{' && r->c != '[')
+        return s_json_scalar (r, NULL);
+
+    bool object = r->c == '{';
+    int close = object ? '}' : ']';
+    if (++r->depth > JSON_MAX_DEPTH)
+        return false;
+    s_json_next (r);
+    s_json_whitespace (r);
+    if (r->c == close) {
+        s_json_next (r);
+        r->depth--;
+        return true;
     }
-    catch (const std::exception& e) {
-        log_error ("Error while parsing JSON: %s", e.what ());
+    while (true) {
+        if (object) {
+            if (r->c != '"' || !s_json_string (r, NULL))
+                return false;
+            s_json_whitespace (r);
+            if (r->c != ':')
+                return false;
+            s_json_next (r);
+            s_json_whitespace (r);
+        }
+        if (!s_json_skip (r))
+            return false;
+        s_json_whitespace (r);
+        if (r->c == ',') {
+            s_json_next (r);
+            s_json_whitespace (r);
+            continue;
+        }
+        if (r->c != close)
+            return false;
+        s_json_next (r);
+        r->depth--;
+        return true;
     }
-    return si;
 }
 
-static char*
-s_get_branding_info
-    (cxxtools::SerializationInfo *si,
-     const char *key,
-     const char * dfl)
+// read object starting at '{'. If object is NULL, store scalar members named
+// in keys to values, otherwise look for member object of that name and
+// extract from it. First occurrence of a key wins.
+static bool
+s_json_object (json_reader_t *r, const char *object, const char **keys, char **values)
 {
-    std::string value;
-    try {
-        si->getMember(key) >>= value;
+    if (++r->depth > JSON_MAX_DEPTH)
+        return false;
+    s_json_next (r);
+    s_json_whitespace (r);
+    if (r->c == '}') {
+        s_json_next (r);
+        r->depth--;
+        return true;
     }
-    catch (const std::exception& e) {
-        log_info ("Problem with getting %s in JSON: %s", key, e.what ());
-        if (dfl) {
-            return strdup(dfl);
-        } else {
-            return NULL;
+    std::string key;
+    while (true) {
+        key.clear ();
+        if (r->c != '"' || !s_json_string (r, &key))
+            return false;
+        s_json_whitespace (r);
+        if (r->c != ':')
+            return false;
+        s_json_next (r);
+        s_json_whitespace (r);
+
+        int slot = -1;
+        if (!object && r->c != '{' && r->c != '[') {
+            for (int i = 0; keys[i]; i++) {
+                if (key == keys[i]) {
+                    slot = i;
+                    break;
+                }
+            }
+        }
+        if (object && r->c == '{' && key == object) {
+            if (!s_json_object (r, NULL, keys, values))
+                return false;
+        }
+        else
+        if (slot != -1) {
+            std::string value;
+            if (!s_json_scalar (r, &value))
+                return false;
+            if (!values[slot])
+                values[slot] = strdup (value.c_str ());
         }
+        else
+        if (!s_json_skip (r))
+            return false;
+
+        s_json_whitespace (r);
+        if (r->c == ',') {
+            s_json_next (r);
+            s_json_whitespace (r);
+            continue;
+        }
+        if (r->c != '}')
+            return false;
+        s_json_next (r);
+        r->depth--;
+        return true;
+    }
+}
+
+//  --------------------------------------------------------------------------
+//  Extract scalar members of a JSON file in one pass, without building
+//  a tree. If object is not NULL, members are taken from the top-level
+//  member object of that name. keys is NULL terminated, values[i] is set
+//  to the value of keys[i] or NULL if not present. Return 0 on success,
+//  -1 if the file cannot be read or parsed (all values are NULL then).
+
+int
+ftyinfo_json_extract (const char *file, const char *object, const char **keys, char **values)
+{
+    size_t count = 0;
+    while (keys[count])
+        values[count++] = NULL;
+
+    FILE *f = fopen (file, "r");
+    if (!f) {
+        log_error ("Error while parsing JSON: cannot open %s: %s", file, strerror (errno));
+        return -1;
+    }
+    json_reader_t reader = {f, 0, 0};
+    s_json_next (&reader);
+    s_json_whitespace (&reader);
+    bool ok = reader.c == '{' && s_json_object (&reader, object, keys, values);
+    if (ok) {
+        s_json_whitespace (&reader);
+        ok = reader.c == EOF;
     }
-    if (value.empty () && dfl) {
-	    return strdup (dfl);
+    fclose (f);
+
+    if (!ok) {
+        log_error ("Error while parsing JSON: %s is not valid", file);
+        for (size_t i = 0; i < count; i++)
+            zstr_free (&values[i]);
+        return -1;
     }
-    return strdup(value.c_str());
+    return 0;
+}
+
+// take ownership of extracted value, use dfl if it is missing or empty
+static char *
+s_json_value (char *value, const char *key, const char *dfl)
+{
+    if (!value) {
+        log_info ("Problem with getting %s in JSON", key);
+        return dfl ? strdup (dfl) : NULL;
+    }
+    if (*value == '\0' && dfl) {
+        zstr_free (&value);
+        return strdup (dfl);
+    }
+    return value;
 }
 
 //  --------------------------------------------------------------------------
@@ -181,16 +408,11 @@ ftyinfo_new (topologyresolver_t *resolver, const char *path)
     self->infos = zhash_new();
 
     // set hostname
-    char *hostname = (char *) malloc (HOST_NAME_MAX+1);
-    int rv = gethostname (hostname, HOST_NAME_MAX+1);
-    if (rv == -1) {
+    self->hostname = localidentity_hostname (localidentity_shared ());
+    if (!self->hostname) {
         log_warning ("ftyinfo could not be fully initialized (error while getting the hostname)");
         self->hostname = strdup("locahost");
     }
-    else {
-        self->hostname = strdup (hostname);
-    }
-    zstr_free (&hostname);
     log_info ("fty-info:hostname  = '%s'", self->hostname);
 
     //set id
@@ -214,15 +436,18 @@ ftyinfo_new (topologyresolver_t *resolver, const char *path)
     log_info ("fty-info:parent_uri= '%s'", self->parent_uri);
 
     //set uuid, vendor, product, part_number, verson from /etc/release-details.json
-    cxxtools::SerializationInfo *si = nullptr;
-    si = s_load_release_details();
-    self->uuid   = s_get_release_details (si, "uuid", NULL);
-    self->vendor = s_get_release_details (si, "hardware-vendor", NULL); // Eaton or OEMs
-    self->manufacturer = strdup("EATON");                               // Eaton only
-    self->serial = s_get_release_details (si, "hardware-serial-number", "N/A");
-    self->product  = s_get_release_details (si, "hardware-catalog-number", NULL);
-    self->part_number  = s_get_release_details (si, "hardware-part-number", NULL);
-    self->version   = s_get_release_details (si, "osimage-name", NULL);
+    const char *release_keys[] = {"uuid", "hardware-vendor", "hardware-serial-number",
+        "hardware-catalog-number", "hardware-part-number", "osimage-name", NULL};
+    char *release[6];
+    if (ftyinfo_json_extract (RELEASE_DETAILS, "release-details", release_keys, release) == 0)
+        log_info("fty-info:load %s OK", RELEASE_DETAILS);
+    self->uuid   = s_json_value (release[0], release_keys[0], NULL);
+    self->vendor = s_json_value (release[1], release_keys[1], NULL); // Eaton or OEMs
+    self->manufacturer = strdup("EATON");                           // Eaton only
+    self->serial = s_json_value (release[2], release_keys[2], "N/A");
+    self->product  = s_json_value (release[3], release_keys[3], NULL);
+    self->part_number  = s_json_value (release[4], release_keys[4], NULL);
+    self->version   = s_json_value (release[5], release_keys[5], NULL);
     log_info ("fty-info:uuid         = '%s'", self->uuid);
     log_info ("fty-info:vendor       = '%s'", self->vendor);
     log_info ("fty-info:manufacturer = '%s'", self->manufacturer);
@@ -232,9 +457,11 @@ ftyinfo_new (topologyresolver_t *resolver, const char *path)
     log_info ("fty-info:version      = '%s'", self->version);
 
     // get complementary branding info
-    cxxtools::SerializationInfo *bi = nullptr;
-    bi = s_load_branding_info();
-    self->licensing_portal = s_get_branding_info (bi, "licensing_portal", "N/A");
+    const char *branding_keys[] = {"licensing_portal", NULL};
+    char *branding[1];
+    if (ftyinfo_json_extract (BRANDING_INFO, NULL, branding_keys, branding) == 0)
+        log_info("fty-info:load %s OK", BRANDING_INFO);
+    self->licensing_portal = s_json_value (branding[0], branding_keys[0], "N/A");
     log_info ("fty-info:licensing_portal = '%s'", self->licensing_portal);
 
     // set description, contact
@@ -275,38 +502,25 @@ ftyinfo_new (topologyresolver_t *resolver, const char *path)
     log_info ("fty-info:type = '%s'", self->type);
     log_info ("fty-info:txtvers = '%s'", self->txtvers);
 
-    // search for IPv4 addresses
-    int counter = 0;
-    for (counter = 0; counter < 3; ++counter) {
-        self->ip[counter] = NULL;
-    }
-    counter = 0;
-    struct ifaddrs *interfaces, *iface;
-    char host[NI_MAXHOST];
-    if (getifaddrs (&interfaces) != -1) {
-        for (iface = interfaces; iface != NULL; iface = iface->ifa_next) {
-            if (iface->ifa_addr == NULL) continue;
-            // here we support IPv4 only, only get first 3 addresses
-            if (iface->ifa_addr->sa_family == AF_INET &&
-                    0 == getnameinfo(iface->ifa_addr,sizeof(struct sockaddr_in),
-                            host, NI_MAXHOST, NULL, 0, NI_NUMERICHOST)) {
-                self->ip[counter] = strdup(host);
-                ++counter;
-            }
-            if (counter == 3) {
-                break;
-            }
-        }
-        freeifaddrs(interfaces);
-    }
+    localidentity_ipv4 (localidentity_shared (), self->ip);
 
-    if(si)
-        delete si;
+    return self;
+}
 
-    if(bi)
-        delete bi;
+//  --------------------------------------------------------------------------
+//  Return list of files ftyinfo_new parses
 
-    return self;
+zlistx_t *
+ftyinfo_input_files (void)
+{
+    zlistx_t *files = zlistx_new ();
+    zlistx_set_destructor (files, (void (*)(void**)) zstr_free);
+    zlistx_add_end (files, strdup (RELEASE_DETAILS));
+    zlistx_add_end (files, strdup (BRANDING_INFO));
+    char *license = s_get_accepted_license_file ();
+    if (license)
+        zlistx_add_end (files, license);
+    return files;
 }
 
 //  --------------------------------------------------------------------------
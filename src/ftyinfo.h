@@ -68,6 +68,9 @@ extern "C" {
 #define HIST_CPU_NUMERATOR	"cpu_usage_numerator"
 #define HIST_CPU_DENOMINATOR	"cpu_usage_denominator"
 #define NETWORK_HISTORY_PREFIX	"network_history"
+#define DISK_HISTORY_PREFIX	"disk_history"
+#define IRQ_HISTORY_PREFIX	"irq_history"
+#define VMSTAT_HISTORY_PREFIX	"vmstat_history"
 
 //  Structure of our class
 
@@ -105,6 +108,18 @@ FTY_INFO_PRIVATE ftyinfo_t *
 FTY_INFO_PRIVATE ftyinfo_t *
     ftyinfo_test_new (void);
 
+//  Extract scalar members of JSON file (of its top-level member object if
+//  object is not NULL) without building a tree. keys is NULL terminated,
+//  values must have the same size, missing values are NULL.
+//  Return 0 on success, -1 on error
+FTY_INFO_PRIVATE int
+    ftyinfo_json_extract (const char *file, const char *object, const char **keys, char **values);
+
+//  Return list of files parsed by ftyinfo_new
+//  Caller must destroy the returned list
+FTY_INFO_PRIVATE zlistx_t *
+    ftyinfo_input_files (void);
+
 //  Destroy the ftyinfo
 FTY_INFO_PRIVATE void
     ftyinfo_destroy (ftyinfo_t **self_p);
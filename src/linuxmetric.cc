@@ -30,7 +30,13 @@
 #include <fstream>
 #include <sstream>
 #include <limits>
+#include <cmath>
+#include <vector>
+#include <set>
+#include <algorithm>
 #include <sys/statvfs.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <cxxtools/directory.h>
 
 #include "fty_info_classes.h"
@@ -122,6 +128,55 @@ s_getline_by_name (std::string filename, const char *name)
     }
 }
 
+// Read the whole file at once, /proc files are generated on each read
+static std::string
+s_read_file (std::string filename)
+{
+    std::ifstream file (filename, std::ifstream::in);
+    if (!file) {
+        log_error ("Could not open '%s'", filename.c_str ());
+        return "";
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf ();
+    return buffer.str ();
+}
+
+// Scan up to max whitespace separated unsigned integers at the start of p.
+// Scanning stops at the first token which is not a number (e.g. interrupt
+// controller name). Returns number of values stored.
+static int
+s_scan_row (const char *p, uint64_t *values, int max)
+{
+    int n = 0;
+    while (n < max) {
+        while (*p == ' ' || *p == '\t')
+            p++;
+        if (*p < '0' || *p > '9')
+            break;
+        uint64_t value = 0;
+        while (*p >= '0' && *p <= '9')
+            value = value * 10 + (*p++ - '0');
+        if (*p != ' ' && *p != '\t' && *p != '\n' && *p != '\0')
+            break;
+        values [n++] = value;
+    }
+    return n;
+}
+
+// Number of "CPUn" columns in header line of /proc/softirqs or /proc/interrupts
+static int
+s_header_cpus (const char *header, std::vector<int> &cpus)
+{
+    // columns are online CPUs only, CPU1 is missing when it is offline
+    cpus.clear ();
+    for (const char *p = header; *p && *p != '\n'; p++) {
+        if (strncmp (p, "CPU", 3) == 0)
+            cpus.push_back (atoi (p + 3));
+    }
+    return (int) cpus.size ();
+}
+
 static double
 s_round (double d)
 {
@@ -197,6 +252,113 @@ s_cpu_temperature (std::string &root_dir)
     return NULL;
 }
 
+// CPU frequency and throttling sources are sysfs files discovered once and
+// kept open, each cycle just re-reads them from the beginning
+
+typedef enum {
+    CPU_SOURCE_FREQUENCY = 0,
+    CPU_SOURCE_CORE_THROTTLE,
+    CPU_SOURCE_PACKAGE_THROTTLE
+} cpu_source_kind_t;
+
+typedef struct {
+    cpu_source_kind_t kind;
+    char *type;         // metric type for frequency sources
+    int fd;
+} cpu_source_t;
+
+static void
+s_cpu_source_destroy (cpu_source_t **self_p)
+{
+    if (*self_p) {
+        cpu_source_t *self = *self_p;
+        if (self->fd >= 0)
+            close (self->fd);
+        zstr_free (&self->type);
+        free (self);
+        *self_p = NULL;
+    }
+}
+
+static void
+s_cpu_source_add (zlistx_t *sources, cpu_source_kind_t kind, const char *type, std::string path)
+{
+    int fd = open (path.c_str (), O_RDONLY | O_CLOEXEC);
+    if (fd == -1)
+        return;
+    cpu_source_t *source = (cpu_source_t *) zmalloc (sizeof (cpu_source_t));
+    source->kind = kind;
+    source->type = type ? strdup (type) : NULL;
+    source->fd = fd;
+    zlistx_add_end (sources, source);
+}
+
+static double
+s_cpu_source_read (cpu_source_t *source)
+{
+    char buffer [32];
+    ssize_t len = pread (source->fd, buffer, sizeof (buffer) - 1, 0);
+    if (len <= 0) {
+        log_error ("Error while reading %s", source->type ? source->type : "throttle count");
+        return std::numeric_limits<double>::quiet_NaN ();
+    }
+    buffer [len] = '\0';
+    return strtod (buffer, NULL);
+}
+
+static zlistx_t *
+s_cpu_frequency (zlistx_t *cpu_sources)
+{
+    zlistx_t *frequency_info = zlistx_new ();
+    if (!cpu_sources)
+        return frequency_info;
+    double core_throttle = 0;
+    double package_throttle = 0;
+    bool have_throttle = false;
+
+    cpu_source_t *source = (cpu_source_t *) zlistx_first (cpu_sources);
+    while (source) {
+        double value = s_cpu_source_read (source);
+        if (!std::isnan (value)) {
+            switch (source->kind) {
+                case CPU_SOURCE_FREQUENCY: {
+                    linuxmetric_t *frequency = linuxmetric_new ();
+                    frequency->type = strdup (source->type);
+                    frequency->value = s_round (value / 1000);
+                    frequency->unit = "MHz";
+                    zlistx_add_end (frequency_info, frequency);
+                    break;
+                }
+                case CPU_SOURCE_CORE_THROTTLE:
+                    core_throttle += value;
+                    have_throttle = true;
+                    break;
+                case CPU_SOURCE_PACKAGE_THROTTLE:
+                    // one source per package
+                    package_throttle += value;
+                    have_throttle = true;
+                    break;
+            }
+        }
+        source = (cpu_source_t *) zlistx_next (cpu_sources);
+    }
+
+    if (have_throttle) {
+        linuxmetric_t *core = linuxmetric_new ();
+        core->type = strdup (LINUXMETRIC_CPU_THROTTLE_COUNT);
+        core->value = core_throttle;
+        core->unit = "";
+        zlistx_add_end (frequency_info, core);
+
+        linuxmetric_t *package = linuxmetric_new ();
+        package->type = strdup (LINUXMETRIC_CPU_PACKAGE_THROTTLE_COUNT);
+        package->value = package_throttle;
+        package->unit = "";
+        zlistx_add_end (frequency_info, package);
+    }
+    return frequency_info;
+}
+
 static zlistx_t *
 s_meminfo (std::string &root_dir)
 {
@@ -323,7 +485,7 @@ static zlistx_t *
     s_network_usage
     (const char *interface,
      const char *direction,
-     int interval,
+     double interval,
      zhashx_t *history,
      std::string &root_dir)
 {
@@ -437,6 +599,435 @@ static linuxmetric_t *
     return error_info;
 }
 
+// Link speed and duplex are read only when the link comes up and cached in
+// history until it goes down again. Speed is stored as capacity in Bps, 0 when
+// the driver does not report it (virtual interfaces).
+static void
+    s_link_capacity
+    (const char *interface,
+     zhashx_t *history,
+     std::string &root_dir,
+     double *capacity,
+     bool *full_duplex)
+{
+    char *speed_key = zsys_sprintf ("%s_%s_speed", NETWORK_HISTORY_PREFIX, interface);
+    char *duplex_key = zsys_sprintf ("%s_%s_duplex", NETWORK_HISTORY_PREFIX, interface);
+    double *speed_ptr = (double *) zhashx_lookup (history, speed_key);
+    double *duplex_ptr = (double *) zhashx_lookup (history, duplex_key);
+
+    if (NULL == speed_ptr || NULL == duplex_ptr) {
+        std::string format_speed (root_dir + "sys/class/net/%s/speed");
+        char *speed_path = zsys_sprintf (format_speed.c_str (), interface);
+        double speed = 0;
+        if (zsys_file_exists (speed_path)) {
+            std::string line = s_getline_by_number (speed_path, 1);
+            speed = s_get_field (line, 1);
+            if (std::isnan (speed) || speed <= 0)
+                speed = 0;
+        }
+        std::string format_duplex (root_dir + "sys/class/net/%s/duplex");
+        char *duplex_path = zsys_sprintf (format_duplex.c_str (), interface);
+        std::string duplex = "full";
+        if (zsys_file_exists (duplex_path))
+            duplex = s_getline_by_number (duplex_path, 1);
+        log_debug ("link %s is up, speed %lf Mbps, duplex %s", interface, speed, duplex.c_str ());
+
+        speed_ptr = (double *) zmalloc (sizeof (double));
+        *speed_ptr = speed * 1000000 / 8; // Mbps -> Bps
+        zhashx_update (history, speed_key, speed_ptr);
+        duplex_ptr = (double *) zmalloc (sizeof (double));
+        *duplex_ptr = (duplex == "half") ? 0 : 1;
+        zhashx_update (history, duplex_key, duplex_ptr);
+
+        zstr_free (&duplex_path);
+        zstr_free (&speed_path);
+    }
+    *capacity = *speed_ptr;
+    *full_duplex = (*duplex_ptr != 0);
+
+    zstr_free (&duplex_key);
+    zstr_free (&speed_key);
+}
+
+// Forget cached link parameters, so they are read again once the link is up
+static void
+s_link_down (const char *interface, zhashx_t *history)
+{
+    char *speed_key = zsys_sprintf ("%s_%s_speed", NETWORK_HISTORY_PREFIX, interface);
+    char *duplex_key = zsys_sprintf ("%s_%s_duplex", NETWORK_HISTORY_PREFIX, interface);
+    zhashx_delete (history, speed_key);
+    zhashx_delete (history, duplex_key);
+    zstr_free (&duplex_key);
+    zstr_free (&speed_key);
+}
+
+static zlistx_t *
+    s_network_utilization
+    (const char *interface,
+     double rx_bandwidth,
+     double tx_bandwidth,
+     zhashx_t *history,
+     std::string &root_dir)
+{
+    zlistx_t *utilization_info = zlistx_new ();
+
+    double capacity;
+    bool full_duplex;
+    s_link_capacity (interface, history, root_dir, &capacity, &full_duplex);
+    if (capacity == 0)
+        return utilization_info;
+
+    // on half duplex link both directions share the capacity
+    double rx_used = full_duplex ? rx_bandwidth : rx_bandwidth + tx_bandwidth;
+    double tx_used = full_duplex ? tx_bandwidth : rx_bandwidth + tx_bandwidth;
+
+    linuxmetric_t *rx_info = linuxmetric_new ();
+    rx_info->type = zsys_sprintf (UTILIZATION_TEMPLATE, "rx", interface);
+    rx_info->value = s_round (100 * rx_used / capacity);
+    rx_info->unit = "%";
+    zlistx_add_end (utilization_info, rx_info);
+
+    linuxmetric_t *tx_info = linuxmetric_new ();
+    tx_info->type = zsys_sprintf (UTILIZATION_TEMPLATE, "tx", interface);
+    tx_info->value = s_round (100 * tx_used / capacity);
+    tx_info->unit = "%";
+    zlistx_add_end (utilization_info, tx_info);
+
+    return utilization_info;
+}
+
+// Append per CPU rates of counters and skew ratio (max / mean rate) to list.
+// Counters are totals since boot, so nothing is appended until every CPU
+// has a previous sample, e.g. on the first collection or once a CPU comes
+// online; history is updated either way.
+static void
+    s_cpu_rates
+    (const char *name,
+     std::vector<int> &cpus,
+     std::vector<uint64_t> &counters,
+     double interval,
+     zhashx_t *history,
+     zlistx_t *list)
+{
+    std::vector<double> rates (counters.size ());
+    bool complete = true;
+    for (size_t cpu = 0; cpu < counters.size (); cpu++) {
+        char *last_key = zsys_sprintf ("%s_%s_%d", IRQ_HISTORY_PREFIX, name, cpus [cpu]);
+        double *value_last_ptr = (double *) zhashx_lookup (history, last_key);
+
+        //store last value
+        if (NULL == value_last_ptr) {
+          complete = false;
+          value_last_ptr = (double *)zmalloc(sizeof(double));
+          *value_last_ptr = counters [cpu];
+          zhashx_insert(history, last_key, value_last_ptr);
+        } else {
+          rates [cpu] = s_round ((counters [cpu] - *value_last_ptr) / interval);
+          *value_last_ptr = counters [cpu];
+        }
+        zstr_free (&last_key);
+    }
+    if (!complete)
+        return;
+
+    double max = 0;
+    double sum = 0;
+    for (size_t cpu = 0; cpu < rates.size (); cpu++) {
+        if (rates [cpu] > max)
+            max = rates [cpu];
+        sum += rates [cpu];
+
+        linuxmetric_t *rate_info = linuxmetric_new ();
+        rate_info->type = zsys_sprintf (CPU_RATE_TEMPLATE, name, cpus [cpu]);
+        rate_info->value = rates [cpu];
+        rate_info->unit = "/s";
+        zlistx_add_end (list, rate_info);
+    }
+
+    // 1 means evenly distributed load, number of CPUs means single CPU does all the work
+    linuxmetric_t *skew_info = linuxmetric_new ();
+    skew_info->type = zsys_sprintf (SKEW_TEMPLATE, name);
+    skew_info->value = (sum > 0) ? max / (sum / counters.size ()) : 1;
+    skew_info->unit = "";
+    zlistx_add_end (list, skew_info);
+}
+
+static zlistx_t *
+s_softirqs (double interval, zhashx_t *history, std::string &root_dir)
+{
+    static const char *wanted [] = {"NET_RX", "NET_TX", "TIMER", NULL};
+    zlistx_t *softirq_info = zlistx_new ();
+
+    std::string content = s_read_file (root_dir + "proc/softirqs");
+    const char *line = content.c_str ();
+    std::vector<int> cpu_ids;
+    int cpus = s_header_cpus (line, cpu_ids);
+    if (cpus == 0)
+        return softirq_info;
+    std::vector<uint64_t> counters (cpus);
+
+    while ((line = strchr (line, '\n')) != NULL) {
+        line++;
+        while (*line == ' ')
+            line++;
+        const char *colon = strchr (line, ':');
+        if (!colon)
+            break;
+        std::string label (line, colon - line);
+        for (int i = 0; wanted [i]; i++) {
+            if (label != wanted [i])
+                continue;
+            std::fill (counters.begin (), counters.end (), 0);
+            s_scan_row (colon + 1, counters.data (), cpus);
+            // NET_RX -> net_rx_softirq
+            for (auto &c : label)
+                c = tolower (c);
+            char *name = zsys_sprintf (SOFTIRQ_TEMPLATE, label.c_str ());
+            s_cpu_rates (name, cpu_ids, counters, interval, history, softirq_info);
+            zstr_free (&name);
+            break;
+        }
+    }
+    return softirq_info;
+}
+
+static zlistx_t *
+s_interrupts (double interval, zhashx_t *history, std::string &root_dir)
+{
+    zlistx_t *interrupts_info = zlistx_new ();
+
+    std::string content = s_read_file (root_dir + "proc/interrupts");
+    const char *line = content.c_str ();
+    std::vector<int> cpu_ids;
+    int cpus = s_header_cpus (line, cpu_ids);
+    if (cpus == 0)
+        return interrupts_info;
+    std::vector<uint64_t> totals (cpus);
+    std::vector<uint64_t> row (cpus);
+
+    while ((line = strchr (line, '\n')) != NULL) {
+        line++;
+        const char *colon = strchr (line, ':');
+        if (!colon)
+            break;
+        // rows like ERR or MIS have a single system-wide counter, skip them
+        if (s_scan_row (colon + 1, row.data (), cpus) != cpus)
+            continue;
+        for (int cpu = 0; cpu < cpus; cpu++)
+            totals [cpu] += row [cpu];
+    }
+    s_cpu_rates (LINUXMETRIC_INTERRUPTS, cpu_ids, totals, interval, history, interrupts_info);
+    return interrupts_info;
+}
+
+// /proc/vmstat counters we are interested in, allocstall is split per memory
+// zone on newer kernels and all of them are summed up
+typedef enum {
+    VMSTAT_OOM_KILL = 0,
+    VMSTAT_PSWPIN,
+    VMSTAT_PSWPOUT,
+    VMSTAT_PGMAJFAULT,
+    VMSTAT_ALLOCSTALL,
+    VMSTAT_COUNT
+} vmstat_counter_t;
+
+static const struct {
+    const char *name;
+    const char *type;
+} s_vmstat_metrics [VMSTAT_COUNT] = {
+    {"oom_kill", LINUXMETRIC_OOM_KILL_RATE},
+    {"pswpin", LINUXMETRIC_SWAP_IN_RATE},
+    {"pswpout", LINUXMETRIC_SWAP_OUT_RATE},
+    {"pgmajfault", LINUXMETRIC_MAJOR_FAULT_RATE},
+    {"allocstall", LINUXMETRIC_ALLOC_STALL_RATE}
+};
+
+// Perfect hash of the wanted keys, the slot still has to be compared
+// with the key as most of /proc/vmstat lines are not wanted
+#define VMSTAT_HASH_SIZE 16
+#define VMSTAT_HASH(key, len) ((2 * (len) + 7 * (key) [(len) - 1] + (key) [0]) & (VMSTAT_HASH_SIZE - 1))
+
+static const struct {
+    const char *key;
+    int counter;
+} s_vmstat_table [VMSTAT_HASH_SIZE] = {
+    {"pgmajfault", VMSTAT_PGMAJFAULT},          // 0
+    {NULL, -1},
+    {NULL, -1},
+    {"oom_kill", VMSTAT_OOM_KILL},              // 3
+    {"allocstall_dma", VMSTAT_ALLOCSTALL},      // 4
+    {NULL, -1},
+    {"allocstall_device", VMSTAT_ALLOCSTALL},   // 6
+    {"allocstall_normal", VMSTAT_ALLOCSTALL},   // 7
+    {"allocstall_movable", VMSTAT_ALLOCSTALL},  // 8
+    {"allocstall", VMSTAT_ALLOCSTALL},          // 9
+    {"pswpout", VMSTAT_PSWPOUT},                // 10
+    {NULL, -1},
+    {NULL, -1},
+    {NULL, -1},
+    {"pswpin", VMSTAT_PSWPIN},                  // 14
+    {"allocstall_dma32", VMSTAT_ALLOCSTALL}     // 15
+};
+
+static int
+s_vmstat_lookup (const char *key, size_t len)
+{
+    if (len == 0)
+        return -1;
+    int slot = VMSTAT_HASH (key, len);
+    const char *candidate = s_vmstat_table [slot].key;
+    if (candidate && strlen (candidate) == len && memcmp (candidate, key, len) == 0)
+        return s_vmstat_table [slot].counter;
+    return -1;
+}
+
+static zlistx_t *
+s_vmstat (double interval, zhashx_t *history, std::string &root_dir)
+{
+    zlistx_t *vmstat_info = zlistx_new ();
+
+    double counters [VMSTAT_COUNT] = {0};
+    bool found [VMSTAT_COUNT] = {false};
+
+    std::string content = s_read_file (root_dir + "proc/vmstat");
+    const char *line = content.c_str ();
+    while (*line) {
+        const char *space = strchr (line, ' ');
+        if (!space)
+            break;
+        int counter = s_vmstat_lookup (line, space - line);
+        if (counter >= 0) {
+            counters [counter] += strtoull (space + 1, NULL, 10);
+            found [counter] = true;
+        }
+        line = strchr (space, '\n');
+        if (!line)
+            break;
+        line++;
+    }
+
+    for (int i = 0; i < VMSTAT_COUNT; i++) {
+        // e.g. oom_kill is available since Linux 4.13
+        if (!found [i])
+            continue;
+
+        char *last_key = zsys_sprintf ("%s_%s", VMSTAT_HISTORY_PREFIX, s_vmstat_metrics [i].name);
+        double *value_last_ptr = (double *) zhashx_lookup (history, last_key);
+
+        // counters are totals since boot, first sample only seeds history
+        if (NULL != value_last_ptr) {
+            linuxmetric_t *rate_info = linuxmetric_new ();
+            rate_info->type = strdup (s_vmstat_metrics [i].type);
+            rate_info->value = s_round ((counters [i] - *value_last_ptr) / interval);
+            rate_info->unit = "/s";
+            zlistx_add_end (vmstat_info, rate_info);
+        }
+
+        //store last value
+        if (NULL == value_last_ptr) {
+          value_last_ptr = (double *)zmalloc(sizeof(double));
+          *value_last_ptr = counters [i];
+          zhashx_insert(history, last_key, value_last_ptr);
+        } else {
+          *value_last_ptr = counters [i];
+        }
+        zstr_free (&last_key);
+    }
+    return vmstat_info;
+}
+
+static zlistx_t *
+    s_block_write
+    (const char *device,
+     double interval,
+     zhashx_t *history,
+     std::string &root_dir)
+{
+    char *last_key = zsys_sprintf ("%s_written_%s", DISK_HISTORY_PREFIX, device);
+    double *value_last_ptr = (double *) zhashx_lookup(history, last_key);
+    if (NULL != value_last_ptr)
+        log_trace ("%s:key found, value %lf", last_key, *value_last_ptr);
+
+    zlistx_t *write_info = zlistx_new ();
+
+    // 7th field of the stat file is number of sectors written, sector is always 512 B
+    std::string format (root_dir + "sys/block/%s/stat");
+    char *path = zsys_sprintf (format.c_str (), device);
+    std::string line = s_getline_by_number (path, 1);
+    double bytes = 512 * s_get_field (line, 7);
+
+    linuxmetric_t *bytes_info = linuxmetric_new ();
+    bytes_info->type = zsys_sprintf (WRITTEN_BYTES_TEMPLATE, device);
+    bytes_info->value = bytes;
+    bytes_info->unit = "B";
+    zlistx_add_end (write_info, bytes_info);
+
+    // bytes written per day, extrapolated from the last interval; there is
+    // nothing to extrapolate from on the first sample, and the counter starts
+    // again from zero when the device is attached again
+    if (NULL != value_last_ptr && bytes >= *value_last_ptr) {
+        linuxmetric_t *rate_info = linuxmetric_new ();
+        rate_info->type = zsys_sprintf (WRITE_RATE_TEMPLATE, device);
+        rate_info->value = s_round ((bytes - *value_last_ptr) * 86400 / interval);
+        rate_info->unit = "B/day";
+        zlistx_add_end (write_info, rate_info);
+    }
+
+    //store last value
+    if (NULL == value_last_ptr) {
+      value_last_ptr = (double *)zmalloc(sizeof(double));
+      *value_last_ptr = bytes;
+      zhashx_insert(history, last_key, value_last_ptr);
+    } else {
+      *value_last_ptr = bytes;
+    }
+
+    zstr_free (&path);
+    zstr_free (&last_key);
+
+    return write_info;
+}
+
+// eMMC wear indicators as defined by JEDEC: life_time holds two estimates
+// (type A and B memory) in 10% steps, pre_eol_info is 1 normal, 2 warning, 3 urgent
+static zlistx_t *
+    s_emmc_wear
+    (const char *device,
+     std::string &root_dir)
+{
+    zlistx_t *wear_info = zlistx_new ();
+
+    std::string format_life (root_dir + "sys/block/%s/device/life_time");
+    char *life_path = zsys_sprintf (format_life.c_str (), device);
+    if (zsys_file_exists (life_path)) {
+        std::string line = s_getline_by_number (life_path, 1);
+        double life_a = s_get_field (line, 1);
+        double life_b = s_get_field (line, 2);
+
+        linuxmetric_t *life_info = linuxmetric_new ();
+        life_info->type = zsys_sprintf (EMMC_LIFE_TIME_TEMPLATE, device);
+        life_info->value = 10 * (life_a > life_b ? life_a : life_b);
+        life_info->unit = "%";
+        zlistx_add_end (wear_info, life_info);
+    }
+
+    std::string format_eol (root_dir + "sys/block/%s/device/pre_eol_info");
+    char *eol_path = zsys_sprintf (format_eol.c_str (), device);
+    if (zsys_file_exists (eol_path)) {
+        std::string line = s_getline_by_number (eol_path, 1);
+
+        linuxmetric_t *eol_info = linuxmetric_new ();
+        eol_info->type = zsys_sprintf (EMMC_PRE_EOL_TEMPLATE, device);
+        eol_info->value = s_get_field (line, 1);
+        eol_info->unit = "";
+        zlistx_add_end (wear_info, eol_info);
+    }
+
+    zstr_free (&eol_path);
+    zstr_free (&life_path);
+    return wear_info;
+}
+
 //  --------------------------------------------------------------------------
 //  Create a new linuxmetric
 
@@ -486,13 +1077,89 @@ linuxmetric_list_interfaces (std::string &root_dir)
     return interfaces;
 }
 
+zlistx_t *
+linuxmetric_list_block_devices (std::string &root_dir)
+{
+    zlistx_t *devices = zlistx_new ();
+    zlistx_set_destructor (devices, (void (*)(void**)) zstr_free);
+
+    std::string path (root_dir + "sys/block/");
+    if (!cxxtools::Directory::exists (path))
+        return devices;
+
+    cxxtools::Directory dir (path);
+    for (cxxtools::DirectoryIterator it = dir.begin (true); it != dir.end (); ++it) {
+        std::string device = *it;
+        // we are not interested in virtual devices
+        if (device.compare (0, 4, "loop") == 0 ||
+            device.compare (0, 3, "ram") == 0 ||
+            device.compare (0, 4, "zram") == 0 ||
+            device.compare (0, 2, "sr") == 0)
+            continue;
+        // device mapper, md raid and the like have no device link, their
+        // writes are already counted on the disks they are stacked on
+        if (!cxxtools::Directory::exists (path + device + "/device"))
+            continue;
+        zlistx_add_end (devices, strdup (device.c_str ()));
+    }
+
+    return devices;
+}
+
+zlistx_t *
+linuxmetric_cpu_sources_new (std::string &root_dir)
+{
+    zlistx_t *sources = zlistx_new ();
+    zlistx_set_destructor (sources, (void (*)(void**)) s_cpu_source_destroy);
+
+    std::string cpufreq_dir (root_dir + "sys/devices/system/cpu/cpufreq/");
+    if (cxxtools::Directory::exists (cpufreq_dir)) {
+        cxxtools::Directory dir (cpufreq_dir);
+        for (cxxtools::DirectoryIterator it = dir.begin (true); it != dir.end (); ++it) {
+            std::string policy = *it;
+            if (policy.compare (0, 6, "policy") != 0)
+                continue;
+            char *type = zsys_sprintf (CPU_FREQUENCY_TEMPLATE, policy.c_str ());
+            s_cpu_source_add (sources, CPU_SOURCE_FREQUENCY, type,
+                cpufreq_dir + policy + "/scaling_cur_freq");
+            zstr_free (&type);
+        }
+    }
+
+    // thermal_throttle is available on x86 only
+    std::string cpu_dir (root_dir + "sys/devices/system/cpu/");
+    if (cxxtools::Directory::exists (cpu_dir)) {
+        std::set<std::string> packages;
+        cxxtools::Directory dir (cpu_dir);
+        for (cxxtools::DirectoryIterator it = dir.begin (true); it != dir.end (); ++it) {
+            std::string cpu = *it;
+            if (cpu.compare (0, 3, "cpu") != 0 || cpu.size () < 4 || !isdigit (cpu [3]))
+                continue;
+            std::string throttle_dir (cpu_dir + cpu + "/thermal_throttle/");
+            s_cpu_source_add (sources, CPU_SOURCE_CORE_THROTTLE, NULL,
+                throttle_dir + "core_throttle_count");
+            // every core reports the counter of its package, one core per
+            // package is enough
+            std::string package = s_read_file (cpu_dir + cpu + "/topology/physical_package_id");
+            if (!packages.insert (package).second)
+                continue;
+            s_cpu_source_add (sources, CPU_SOURCE_PACKAGE_THROTTLE, NULL,
+                throttle_dir + "package_throttle_count");
+        }
+    }
+
+    log_debug ("found %zu cpu frequency and throttling sources", zlistx_size (sources));
+    return sources;
+}
+
 //--------------------------------------------------------------------------
 //// Create zlistx containing all Linux system info
 
 zlistx_t *
 linuxmetric_get_all
-    (int interval,
+    (double interval,
      zhashx_t *history,
+     zlistx_t *cpu_sources,
      std::string &root_dir,
      bool metrics_test)
 {
@@ -506,6 +1173,14 @@ linuxmetric_get_all
     if (cpu_temperature != NULL)
         zlistx_add_end (info, cpu_temperature);
 
+    zlistx_t *frequency = s_cpu_frequency (cpu_sources);
+    linuxmetric_t *frequency_metric = (linuxmetric_t *) zlistx_first (frequency);
+    while (frequency_metric) {
+        zlistx_add_end (info, frequency_metric);
+        frequency_metric = (linuxmetric_t *) zlistx_next (frequency);
+    }
+    zlistx_destroy (&frequency);
+
     zlistx_t *meminfo = s_meminfo (root_dir);
     linuxmetric_t *mem_metric = (linuxmetric_t *) zlistx_first (meminfo);
     while (mem_metric) {
@@ -514,6 +1189,30 @@ linuxmetric_get_all
     }
     zlistx_destroy (&meminfo);
 
+    zlistx_t *softirqs = s_softirqs (interval, history, root_dir);
+    linuxmetric_t *irq_metric = (linuxmetric_t *) zlistx_first (softirqs);
+    while (irq_metric) {
+        zlistx_add_end (info, irq_metric);
+        irq_metric = (linuxmetric_t *) zlistx_next (softirqs);
+    }
+    zlistx_destroy (&softirqs);
+
+    zlistx_t *interrupts = s_interrupts (interval, history, root_dir);
+    irq_metric = (linuxmetric_t *) zlistx_first (interrupts);
+    while (irq_metric) {
+        zlistx_add_end (info, irq_metric);
+        irq_metric = (linuxmetric_t *) zlistx_next (interrupts);
+    }
+    zlistx_destroy (&interrupts);
+
+    zlistx_t *vmstat = s_vmstat (interval, history, root_dir);
+    linuxmetric_t *vmstat_metric = (linuxmetric_t *) zlistx_first (vmstat);
+    while (vmstat_metric) {
+        zlistx_add_end (info, vmstat_metric);
+        vmstat_metric = (linuxmetric_t *) zlistx_next (vmstat);
+    }
+    zlistx_destroy (&vmstat);
+
     if (!metrics_test) {
         zlistx_t *sdcard_info = s_sdcard_info (root_dir);
         linuxmetric_t *sdcard_metric = (linuxmetric_t *) zlistx_first (sdcard_info);
@@ -578,8 +1277,10 @@ linuxmetric_get_all
         log_trace ("interface %s = %s", iface, state);
 
         if (streq (state, "up")) {
+            // first metric of s_network_usage is the bandwidth
             zlistx_t *rx = s_network_usage (iface, "rx", interval, history, root_dir);
             linuxmetric_t *network_usage_metric = (linuxmetric_t *) zlistx_first (rx);
+            double rx_bandwidth = network_usage_metric->value;
             while (network_usage_metric) {
                 zlistx_add_end (info, network_usage_metric);
                 network_usage_metric = (linuxmetric_t *) zlistx_next (rx);
@@ -588,12 +1289,21 @@ linuxmetric_get_all
 
             zlistx_t *tx = s_network_usage (iface, "tx", interval, history, root_dir);
             network_usage_metric = (linuxmetric_t *) zlistx_first (tx);
+            double tx_bandwidth = network_usage_metric->value;
             while (network_usage_metric) {
                 zlistx_add_end (info, network_usage_metric);
                 network_usage_metric = (linuxmetric_t *) zlistx_next (tx);
             }
             zlistx_destroy (&tx);
 
+            zlistx_t *utilization = s_network_utilization (iface, rx_bandwidth, tx_bandwidth, history, root_dir);
+            network_usage_metric = (linuxmetric_t *) zlistx_first (utilization);
+            while (network_usage_metric) {
+                zlistx_add_end (info, network_usage_metric);
+                network_usage_metric = (linuxmetric_t *) zlistx_next (utilization);
+            }
+            zlistx_destroy (&utilization);
+
             linuxmetric_t *rx_error = s_network_error_ratio (iface, "rx", history, root_dir);
             if (rx_error != NULL)
                 zlistx_add_end (info, rx_error);
@@ -602,8 +1312,34 @@ linuxmetric_get_all
             if (tx_error != NULL)
                 zlistx_add_end (info, tx_error);
         }
+        else
+            s_link_down (iface, history);
         state = (const char *) zhashx_next (interfaces);
     }
     zhashx_destroy (&interfaces);
+
+    // loop over all block devices
+    zlistx_t *devices = linuxmetric_list_block_devices (root_dir);
+    const char *device = (const char *) zlistx_first (devices);
+    while (device) {
+        zlistx_t *write_info = s_block_write (device, interval, history, root_dir);
+        linuxmetric_t *block_metric = (linuxmetric_t *) zlistx_first (write_info);
+        while (block_metric) {
+            zlistx_add_end (info, block_metric);
+            block_metric = (linuxmetric_t *) zlistx_next (write_info);
+        }
+        zlistx_destroy (&write_info);
+
+        zlistx_t *wear_info = s_emmc_wear (device, root_dir);
+        block_metric = (linuxmetric_t *) zlistx_first (wear_info);
+        while (block_metric) {
+            zlistx_add_end (info, block_metric);
+            block_metric = (linuxmetric_t *) zlistx_next (wear_info);
+        }
+        zlistx_destroy (&wear_info);
+
+        device = (const char *) zlistx_next (devices);
+    }
+    zlistx_destroy (&devices);
     return info;
 }
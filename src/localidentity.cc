@@ -0,0 +1,477 @@
+/*  =========================================================================
+    localidentity - Class for tracking local IP addresses and hostname
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+/*
+@header
+    localidentity - Class for tracking local IP addresses and hostname
+@discuss
+    Addresses are loaded by a RTM_GETADDR dump and then kept current from
+    RTM_NEWADDR/RTM_DELADDR events of a netlink socket, so queries do not
+    need getifaddrs. Events are applied only by localidentity_update, called
+    by the owner of the socket when it is readable; queries return the state
+    as of the last update, so they never take a change away from the owner.
+    Hostname is read once and again on request (when /etc/hostname changes)
+    or when addresses change.
+
+    One instance is shared by all actors of the process, it is protected
+    by a mutex.
+@end
+*/
+
+#include "fty_info_classes.h"
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <arpa/inet.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+typedef std::vector<std::pair<int, std::string>> addresses_t;   // family, address
+
+//  Structure of our class
+
+struct _localidentity_t {
+    int fd;                                     // netlink socket with events
+    std::mutex mutex;
+    std::map<int, addresses_t> interfaces;      // interface index -> addresses
+    std::unordered_map<std::string, int> addresses; // address -> interface count
+    std::string hostname;
+    uint64_t generation;    // incremented on every change of addresses or hostname
+};
+
+//  --------------------------------------------------------------------------
+//  Add address to interface, return true if it was not there
+static bool
+s_address_add (localidentity_t *self, int index, int family, const char *address)
+{
+    addresses_t &iface = self->interfaces [index];
+    for (auto &it : iface)
+        if (it.second == address)
+            return false;
+    iface.push_back (std::make_pair (family, std::string (address)));
+    self->addresses [address]++;
+    return true;
+}
+
+//  --------------------------------------------------------------------------
+//  Remove address from interface, return true if it was there
+static bool
+s_address_remove (localidentity_t *self, int index, const char *address)
+{
+    auto iface = self->interfaces.find (index);
+    if (iface == self->interfaces.end ())
+        return false;
+    for (auto it = iface->second.begin (); it != iface->second.end (); ++it) {
+        if (it->second == address) {
+            iface->second.erase (it);
+            if (iface->second.empty ())
+                self->interfaces.erase (iface);
+            auto count = self->addresses.find (address);
+            if (--count->second == 0)
+                self->addresses.erase (count);
+            return true;
+        }
+    }
+    return false;
+}
+
+//  --------------------------------------------------------------------------
+//  Apply one RTM_NEWADDR/RTM_DELADDR message, return true if anything changed
+static bool
+s_handle_message (localidentity_t *self, struct nlmsghdr *nh)
+{
+    if (nh->nlmsg_type != RTM_NEWADDR && nh->nlmsg_type != RTM_DELADDR)
+        return false;
+    struct ifaddrmsg *ifa = (struct ifaddrmsg *) NLMSG_DATA (nh);
+    if (ifa->ifa_family != AF_INET && ifa->ifa_family != AF_INET6)
+        return false;
+
+    // IFA_LOCAL is the local address on point-to-point links, IFA_ADDRESS
+    // is the peer there; elsewhere (and always for IPv6) only IFA_ADDRESS
+    const void *address = NULL;
+    const void *local = NULL;
+    int len = IFA_PAYLOAD (nh);
+    for (struct rtattr *rta = IFA_RTA (ifa); RTA_OK (rta, len); rta = RTA_NEXT (rta, len)) {
+        if (rta->rta_type == IFA_ADDRESS)
+            address = RTA_DATA (rta);
+        else
+        if (rta->rta_type == IFA_LOCAL)
+            local = RTA_DATA (rta);
+    }
+    if (local)
+        address = local;
+    if (!address)
+        return false;
+
+    char host [INET6_ADDRSTRLEN];
+    if (!inet_ntop (ifa->ifa_family, address, host, sizeof (host)))
+        return false;
+    if (nh->nlmsg_type == RTM_NEWADDR)
+        return s_address_add (self, ifa->ifa_index, ifa->ifa_family, host);
+    return s_address_remove (self, ifa->ifa_index, host);
+}
+
+//  --------------------------------------------------------------------------
+//  Reload all addresses by RTM_GETADDR dump, return true if anything changed
+static bool
+s_dump (localidentity_t *self)
+{
+    int fd = socket (AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if (fd == -1) {
+        log_error ("fty-info: cannot open netlink socket: %s", strerror (errno));
+        return false;
+    }
+    struct {
+        struct nlmsghdr nh;
+        struct ifaddrmsg ifa;
+    } request;
+    memset (&request, 0, sizeof (request));
+    request.nh.nlmsg_len = NLMSG_LENGTH (sizeof (struct ifaddrmsg));
+    request.nh.nlmsg_type = RTM_GETADDR;
+    request.nh.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    request.nh.nlmsg_seq = 1;
+    request.ifa.ifa_family = AF_UNSPEC;
+    if (send (fd, &request, request.nh.nlmsg_len, 0) == -1) {
+        log_error ("fty-info: cannot request addresses: %s", strerror (errno));
+        close (fd);
+        return false;
+    }
+
+    std::map<int, addresses_t> interfaces;
+    self->interfaces.swap (interfaces);
+    self->addresses.clear ();
+
+    char buffer [8192] __attribute__ ((aligned (__alignof__ (struct nlmsghdr))));
+    bool done = false;
+    while (!done) {
+        int len = recv (fd, buffer, sizeof (buffer), 0);
+        if (len <= 0)
+            break;
+        for (struct nlmsghdr *nh = (struct nlmsghdr *) buffer; NLMSG_OK (nh, len); nh = NLMSG_NEXT (nh, len)) {
+            if (nh->nlmsg_type == NLMSG_DONE || nh->nlmsg_type == NLMSG_ERROR) {
+                done = true;
+                break;
+            }
+            s_handle_message (self, nh);
+        }
+    }
+    close (fd);
+    return interfaces != self->interfaces;
+}
+
+//  --------------------------------------------------------------------------
+//  Apply pending events of the netlink socket, return true if anything
+//  changed. Caller must hold the mutex.
+static bool
+s_drain (localidentity_t *self)
+{
+    if (self->fd == -1)
+        return false;
+
+    bool changed = false;
+    char buffer [8192] __attribute__ ((aligned (__alignof__ (struct nlmsghdr))));
+    while (true) {
+        int len = recv (self->fd, buffer, sizeof (buffer), MSG_DONTWAIT);
+        if (len == -1 && errno == ENOBUFS) {
+            // socket buffer overflowed, events were lost
+            log_warning ("fty-info: netlink events lost, reloading addresses");
+            changed = s_dump (self) || changed;
+            continue;
+        }
+        if (len <= 0)
+            break;
+        for (struct nlmsghdr *nh = (struct nlmsghdr *) buffer; NLMSG_OK (nh, len); nh = NLMSG_NEXT (nh, len))
+            changed = s_handle_message (self, nh) || changed;
+    }
+    if (changed)
+        self->generation++;
+    return changed;
+}
+
+//  --------------------------------------------------------------------------
+//  Read hostname, return true if it changed. Caller must hold the mutex.
+static bool
+s_read_hostname (localidentity_t *self)
+{
+    char hostname [HOST_NAME_MAX+1];
+    if (gethostname (hostname, sizeof (hostname)) == -1) {
+        log_warning ("fty-info: cannot get hostname: %s", strerror (errno));
+        return false;
+    }
+    hostname [HOST_NAME_MAX] = '\0';
+    if (self->hostname == hostname)
+        return false;
+    self->hostname = hostname;
+    self->generation++;
+    return true;
+}
+
+//  --------------------------------------------------------------------------
+//  Create a new localidentity
+
+localidentity_t *
+localidentity_new (void)
+{
+    localidentity_t *self = new localidentity_t ();
+    self->generation = 0;
+
+    // subscribe before the dump, so no change is missed in between
+    self->fd = socket (AF_NETLINK, SOCK_RAW | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if (self->fd != -1) {
+        struct sockaddr_nl addr;
+        memset (&addr, 0, sizeof (addr));
+        addr.nl_family = AF_NETLINK;
+        addr.nl_groups = RTMGRP_IPV4_IFADDR | RTMGRP_IPV6_IFADDR;
+        if (bind (self->fd, (struct sockaddr *) &addr, sizeof (addr)) == -1) {
+            log_error ("fty-info: cannot bind netlink socket: %s", strerror (errno));
+            close (self->fd);
+            self->fd = -1;
+        }
+    }
+    else
+        log_error ("fty-info: cannot open netlink socket: %s", strerror (errno));
+
+    s_dump (self);
+    s_read_hostname (self);
+    self->generation = 0;
+    return self;
+}
+
+//  --------------------------------------------------------------------------
+//  Destroy the localidentity
+
+void
+localidentity_destroy (localidentity_t **self_p)
+{
+    assert (self_p);
+    if (*self_p) {
+        localidentity_t *self = *self_p;
+        if (self->fd != -1)
+            close (self->fd);
+        delete self;
+        *self_p = NULL;
+    }
+}
+
+//  --------------------------------------------------------------------------
+//  Return localidentity shared by the whole process
+
+localidentity_t *
+localidentity_shared (void)
+{
+    static localidentity_t *shared = localidentity_new ();
+    return shared;
+}
+
+//  --------------------------------------------------------------------------
+//  Return netlink socket delivering address changes
+
+int
+localidentity_fd (localidentity_t *self)
+{
+    assert (self);
+    return self->fd;
+}
+
+//  --------------------------------------------------------------------------
+//  Process pending address changes, return true if addresses changed
+
+bool
+localidentity_update (localidentity_t *self)
+{
+    assert (self);
+    std::lock_guard<std::mutex> lock (self->mutex);
+    if (!s_drain (self))
+        return false;
+    // DHCP may set new hostname together with new address
+    s_read_hostname (self);
+    return true;
+}
+
+//  --------------------------------------------------------------------------
+//  Read hostname again, return true if it changed
+
+bool
+localidentity_update_hostname (localidentity_t *self)
+{
+    assert (self);
+    std::lock_guard<std::mutex> lock (self->mutex);
+    return s_read_hostname (self);
+}
+
+//  --------------------------------------------------------------------------
+//  Return number of changes of addresses and hostname so far
+
+uint64_t
+localidentity_generation (localidentity_t *self)
+{
+    assert (self);
+    std::lock_guard<std::mutex> lock (self->mutex);
+    return self->generation;
+}
+
+//  --------------------------------------------------------------------------
+//  Return hostname or NULL if unknown
+
+char *
+localidentity_hostname (localidentity_t *self)
+{
+    assert (self);
+    std::lock_guard<std::mutex> lock (self->mutex);
+    if (self->hostname.empty ())
+        return NULL;
+    return strdup (self->hostname.c_str ());
+}
+
+//  --------------------------------------------------------------------------
+//  Fill first 3 IPv4 addresses in order of interfaces
+
+void
+localidentity_ipv4 (localidentity_t *self, char *ip[3])
+{
+    assert (self);
+    for (int i = 0; i < 3; ++i)
+        ip[i] = NULL;
+
+    std::lock_guard<std::mutex> lock (self->mutex);
+    int counter = 0;
+    for (auto &iface : self->interfaces) {
+        for (auto &address : iface.second) {
+            if (address.first != AF_INET)
+                continue;
+            ip[counter++] = strdup (address.second.c_str ());
+            if (counter == 3)
+                return;
+        }
+    }
+}
+
+//  --------------------------------------------------------------------------
+//  Return true if address is assigned to a local interface
+
+bool
+localidentity_is_local (localidentity_t *self, const char *address)
+{
+    assert (self);
+    if (!address)
+        return false;
+    std::lock_guard<std::mutex> lock (self->mutex);
+    return self->addresses.find (address) != self->addresses.end ();
+}
+
+//  --------------------------------------------------------------------------
+//  Build RTM_NEWADDR/RTM_DELADDR message for tests
+
+static struct nlmsghdr *
+s_test_message (char *buffer, int type, int index, const char *address)
+{
+    struct nlmsghdr *nh = (struct nlmsghdr *) buffer;
+    memset (buffer, 0, NLMSG_SPACE (sizeof (struct ifaddrmsg)) + RTA_SPACE (4));
+    nh->nlmsg_len = NLMSG_LENGTH (sizeof (struct ifaddrmsg)) + RTA_SPACE (4);
+    nh->nlmsg_type = type;
+    struct ifaddrmsg *ifa = (struct ifaddrmsg *) NLMSG_DATA (nh);
+    ifa->ifa_family = AF_INET;
+    ifa->ifa_index = index;
+    struct rtattr *rta = IFA_RTA (ifa);
+    rta->rta_type = IFA_LOCAL;
+    rta->rta_len = RTA_LENGTH (4);
+    inet_pton (AF_INET, address, RTA_DATA (rta));
+    return nh;
+}
+
+//  --------------------------------------------------------------------------
+//  Self test of this class
+
+void
+localidentity_test (bool verbose)
+{
+    printf (" * localidentity: ");
+
+    //  @selftest
+    localidentity_t *self = localidentity_new ();
+    assert (self);
+
+    char hostname [HOST_NAME_MAX+1];
+    if (gethostname (hostname, sizeof (hostname)) == 0) {
+        char *cached = localidentity_hostname (self);
+        assert (cached && streq (cached, hostname));
+        zstr_free (&cached);
+    }
+    assert (!localidentity_is_local (self, "192.0.2.1"));
+
+    // forget real addresses, apply events to interfaces 1000 and 1001
+    self->interfaces.clear ();
+    self->addresses.clear ();
+    char buffer [256] __attribute__ ((aligned (__alignof__ (struct nlmsghdr))));
+    assert (s_handle_message (self, s_test_message (buffer, RTM_NEWADDR, 1000, "192.0.2.1")));
+    assert (!s_handle_message (self, s_test_message (buffer, RTM_NEWADDR, 1000, "192.0.2.1")));
+    assert (s_handle_message (self, s_test_message (buffer, RTM_NEWADDR, 1001, "192.0.2.2")));
+    assert (s_handle_message (self, s_test_message (buffer, RTM_NEWADDR, 1001, "192.0.2.1")));
+    assert (localidentity_is_local (self, "192.0.2.1"));
+
+    char *ip[3];
+    localidentity_ipv4 (self, ip);
+    assert (ip[0] && streq (ip[0], "192.0.2.1"));
+    assert (ip[1] && streq (ip[1], "192.0.2.2"));
+    assert (ip[2] && streq (ip[2], "192.0.2.1"));
+    for (int i = 0; i < 3; ++i)
+        zstr_free (&ip[i]);
+
+    assert (s_handle_message (self, s_test_message (buffer, RTM_DELADDR, 1000, "192.0.2.1")));
+    assert (localidentity_is_local (self, "192.0.2.1"));
+    assert (s_handle_message (self, s_test_message (buffer, RTM_DELADDR, 1001, "192.0.2.1")));
+    assert (!s_handle_message (self, s_test_message (buffer, RTM_DELADDR, 1001, "192.0.2.1")));
+    assert (!localidentity_is_local (self, "192.0.2.1"));
+
+    // queries between an event and update do not take the event away
+    int pair [2];
+    assert (socketpair (AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0, pair) == 0);
+    if (self->fd != -1)
+        close (self->fd);
+    self->fd = pair [0];
+    uint64_t generation = localidentity_generation (self);
+    struct nlmsghdr *nh = s_test_message (buffer, RTM_NEWADDR, 1002, "192.0.2.3");
+    assert (send (pair [1], nh, nh->nlmsg_len, 0) == (ssize_t) nh->nlmsg_len);
+    assert (!localidentity_is_local (self, "192.0.2.3"));
+    localidentity_ipv4 (self, ip);
+    assert (ip[0] && streq (ip[0], "192.0.2.2"));
+    assert (ip[1] == NULL);
+    zstr_free (&ip[0]);
+    assert (localidentity_generation (self) == generation);
+    assert (localidentity_update (self));
+    assert (localidentity_is_local (self, "192.0.2.3"));
+    assert (localidentity_generation (self) == generation + 1);
+    assert (!localidentity_update (self));
+    close (pair [1]);
+
+    localidentity_destroy (&self);
+    assert (self == NULL);
+
+    assert (localidentity_shared () == localidentity_shared ());
+    //  @end
+    printf ("OK\n");
+}
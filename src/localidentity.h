@@ -0,0 +1,83 @@
+/*  =========================================================================
+    localidentity - Class for tracking local IP addresses and hostname
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#ifndef LOCALIDENTITY_H_INCLUDED
+#define LOCALIDENTITY_H_INCLUDED
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//  @interface
+//  Create a new localidentity, load current addresses and hostname
+FTY_INFO_PRIVATE localidentity_t *
+    localidentity_new (void);
+
+//  Destroy the localidentity
+FTY_INFO_PRIVATE void
+    localidentity_destroy (localidentity_t **self_p);
+
+//  Return localidentity shared by the whole process
+FTY_INFO_PRIVATE localidentity_t *
+    localidentity_shared (void);
+
+//  Return netlink socket delivering address changes, -1 if not available.
+//  Call localidentity_update when it is readable.
+FTY_INFO_PRIVATE int
+    localidentity_fd (localidentity_t *self);
+
+//  Process pending address changes, return true if addresses changed
+FTY_INFO_PRIVATE bool
+    localidentity_update (localidentity_t *self);
+
+//  Read hostname again, return true if it changed
+FTY_INFO_PRIVATE bool
+    localidentity_update_hostname (localidentity_t *self);
+
+//  Queries below return the state as of the last localidentity_update.
+
+//  Return number of changes of addresses and hostname so far
+FTY_INFO_PRIVATE uint64_t
+    localidentity_generation (localidentity_t *self);
+
+//  Return hostname or NULL if unknown, caller must free it
+FTY_INFO_PRIVATE char *
+    localidentity_hostname (localidentity_t *self);
+
+//  Fill first 3 IPv4 addresses, unused slots are NULL, caller must free them
+FTY_INFO_PRIVATE void
+    localidentity_ipv4 (localidentity_t *self, char *ip[3]);
+
+//  Return true if address (IPv4 or IPv6) is assigned to a local interface
+FTY_INFO_PRIVATE bool
+    localidentity_is_local (localidentity_t *self, const char *address);
+
+//  Self test of this class
+FTY_INFO_PRIVATE void
+    localidentity_test (bool verbose);
+
+//  @end
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -27,11 +27,12 @@
 */
 
 #include "fty_info_classes.h"
-#include <map>
-#include <set>
+#include <cinttypes>
 
 // State
 #define DEFAULT_ENDPOINT "ipc://@/malamute"
+// msec to wait for ASSET_DETAIL reply before asking again
+#define REQUEST_TIMEOUT_MS 5000
 
 typedef enum {
     DISCOVERING = 0,
@@ -43,51 +44,32 @@ typedef enum {
 struct _topologyresolver_t {
     char *iname;
     char *topology;
-    const char * endpoint;
     ResolverState state;
     zhashx_t *assets;
-    mlm_client_t *client;
+    mlm_client_t *client;   // shared with the owner, replies come through topologyresolver_reply
+    zhashx_t *requests;     // pending ASSET_DETAIL requests, uuid -> request_t
+    int request_timeout;    // msec to wait for ASSET_DETAIL reply
+    fty_info_clock_t *clock;    // not owned, system clock if NULL
+    bool batch_details;     // ASSET AGENT answers ASSET_DETAIL for many assets at once
+    uint64_t generation;    // incremented on every change of cached assets
+    bool batch;             // assets are cached only, until topologyresolver_commit
+    bool batch_changed;     // cache changed since topologyresolver_begin
 };
 
-static std::map<std::string,std::set<std::string>>
-s_local_addresses()
-{
-    struct ifaddrs *interfaces, *iface;
-    char host[NI_MAXHOST];
-    std::map<std::string,std::set<std::string>> result;
-
-    if (getifaddrs (&interfaces) == -1) {
-        return result;
-    }
-    iface = interfaces;
-    for (iface = interfaces; iface != NULL; iface = iface->ifa_next) {
-        if (iface->ifa_addr == NULL) continue;
-        int family = iface->ifa_addr->sa_family;
-        if (family == AF_INET || family == AF_INET6) {
-            if (
-                    getnameinfo(iface->ifa_addr,
-                        (family == AF_INET) ? sizeof(struct sockaddr_in) :
-                        sizeof(struct sockaddr_in6),
-                        host, NI_MAXHOST,
-                        NULL, 0, NI_NUMERICHOST) == 0
-               ) {
-                // sometimes IPv6 addres looks like ::2342%IfaceName
-                char *p = strchr (host, '%');
-                if (p) *p = 0;
-
-                auto it = result.find (iface->ifa_name);
-                if (it == result.end()) {
-                    std::set<std::string> aSet;
-                    aSet.insert (host);
-                    result [iface->ifa_name] = aSet;
-                } else {
-                    result [iface->ifa_name].insert (host);
-                }
-            }
-        }
+//  Pending ASSET_DETAIL request
+typedef struct {
+    zlistx_t *inames;       // assets asked for, in order of reply frames
+    int64_t expires;        // monotonic time the request is given up
+} request_t;
+
+static void
+s_request_destroy (request_t **self_p)
+{
+    if (*self_p) {
+        zlistx_destroy (&(*self_p)->inames);
+        free (*self_p);
+        *self_p = NULL;
     }
-    freeifaddrs (interfaces);
-    return result;
 }
 
 //check if this is our rack controller - is any IP address
@@ -102,7 +84,7 @@ static bool s_is_this_me (fty_proto_t *asset)
         const char *type = fty_proto_aux_string (asset, "type", "");
         const char *subtype = fty_proto_aux_string (asset, "subtype", "");
         if (streq (type, "device") && streq (subtype, "rackcontroller")) {
-            auto ifaces = s_local_addresses ();
+            localidentity_t *local = localidentity_shared ();
             zhash_t *ext = fty_proto_ext (asset);
 
             int ipv6_index = 1;
@@ -111,13 +93,7 @@ static bool s_is_this_me (fty_proto_t *asset)
                 void *ip = zhash_lookup (ext, ("ipv6." + std::to_string (ipv6_index)).c_str ());
                 ipv6_index++;
                 if (ip != NULL) {
-                    for (auto &iface : ifaces) {
-                        if (iface.second.find ((char *)ip) != iface.second.end ()) {
-                            found = true;
-                            //try another network interface only if match was not found
-                            break;
-                        }
-                    }
+                    found = localidentity_is_local (local, (char *) ip);
                     // try another address only if match was not found
                     if (found)
                         break;
@@ -133,13 +109,7 @@ static bool s_is_this_me (fty_proto_t *asset)
                 void *ip = zhash_lookup (ext, ("ip." + std::to_string (ipv4_index)).c_str ());
                 ipv4_index++;
                 if (ip != NULL) {
-                    for (auto &iface : ifaces) {
-                        if (iface.second.find ((char *)ip) != iface.second.end ()) {
-                            found = true;
-                            //try another network interface only if match was not found
-                            break;
-                        }
-                    }
+                    found = localidentity_is_local (local, (char *) ip);
                     // try another address only if match was not found
                     if (found)
                         break;
@@ -154,11 +124,10 @@ static bool s_is_this_me (fty_proto_t *asset)
 }
 
 static void
-s_purge_message_cache (topologyresolver_t *self)
+s_purge_message_cache (topologyresolver_t *self, zlistx_t *topo)
 {
     if (!self || !self->assets) return;
 
-    zlistx_t *topo = topologyresolver_to_list (self);
     zlistx_t *inames = zhashx_keys (self->assets);
 
     const char *iname = (char *) zlistx_first (inames);
@@ -169,10 +138,28 @@ s_purge_message_cache (topologyresolver_t *self)
         }
         iname = (char *) zlistx_next (inames);
     }
-    zlistx_destroy (&topo);
     zlistx_destroy (&inames);
 }
 
+//  is iname one of parents named in my own message?
+static bool
+s_is_my_parent (topologyresolver_t *self, const char *iname)
+{
+    if (! self->iname)
+        return false;
+    fty_proto_t *msg = (fty_proto_t *) zhashx_lookup (self->assets, self->iname);
+    if (! msg)
+        return false;
+    char buffer[16]; // strlen ("parent_name.123") + 1
+    for (int i=1; i<100; i++) {
+        snprintf (buffer, 16, "parent_name.%i", i);
+        const char *parent = fty_proto_aux_string (msg, buffer, NULL);
+        if (! parent) break;
+        if (streq (parent, iname)) return true;
+    }
+    return false;
+}
+
 //  --------------------------------------------------------------------------
 //  Create a new topologyresolver
 
@@ -187,7 +174,12 @@ topologyresolver_new (const char *iname)
     self->assets = zhashx_new ();
     zhashx_set_destructor (self->assets, (czmq_destructor *) fty_proto_destroy);
     zhashx_set_duplicator (self->assets, (czmq_duplicator *) fty_proto_dup);
-    self->client = mlm_client_new ();
+    self->client = NULL;
+    self->requests = zhashx_new ();
+    zhashx_set_destructor (self->requests, (czmq_destructor *) s_request_destroy);
+    self->request_timeout = REQUEST_TIMEOUT_MS;
+    self->clock = NULL;
+    self->batch_details = true;
     return self;
 }
 
@@ -205,7 +197,7 @@ topologyresolver_destroy (topologyresolver_t **self_p)
         zhashx_destroy (&self->assets);
         zstr_free (&self->iname);
         zstr_free (&self->topology);
-        mlm_client_destroy (&self->client);
+        zhashx_destroy (&self->requests);
         //  Free object itself
         free (self);
         *self_p = NULL;
@@ -213,12 +205,28 @@ topologyresolver_destroy (topologyresolver_t **self_p)
 }
 
 //  --------------------------------------------------------------------------
-//  set endpoint of topologyresolver
+//  Set Malamute client used to ask ASSET AGENT for missing assets. Client is
+//  not owned, its owner passes ASSET_DETAIL replies to topologyresolver_reply.
 void
-topologyresolver_set_endpoint (topologyresolver_t *self, const char *endpoint)
+topologyresolver_set_client (topologyresolver_t *self, mlm_client_t *client)
 {
-    self->endpoint = endpoint;
-    mlm_client_connect (self->client, endpoint, 1000, "fty_info_topologyresolver");
+    self->client = client;
+}
+
+//  --------------------------------------------------------------------------
+//  Set msec to wait for ASSET_DETAIL reply before the asset is asked for again
+void
+topologyresolver_set_timeout (topologyresolver_t *self, int timeout)
+{
+    self->request_timeout = timeout;
+}
+
+//  --------------------------------------------------------------------------
+//  Set clock ASSET_DETAIL requests expire on, it must outlive the resolver
+void
+topologyresolver_set_clock (topologyresolver_t *self, fty_info_clock_t *clock)
+{
+    self->clock = clock;
 }
 
 //  --------------------------------------------------------------------------
@@ -246,12 +254,27 @@ topologyresolver_asset (topologyresolver_t *self, fty_proto_t *message)
     // is this message about me?
     if (!self->iname && s_is_this_me (message)) {
         self->iname = strdup (fty_proto_name (message));
+        self->generation++;
         // previous code wasn't doing republish at this point
         return false;
     }
+    if (self->batch) {
+        // cache what may belong to the topology, topologyresolver_commit
+        // resolves it once for the whole batch
+        if ((self->iname && streq (self->iname, iname))
+                || self->state == DISCOVERING
+                || zhashx_lookup (self->assets, iname)
+                || s_is_my_parent (self, iname)) {
+            zhashx_update (self->assets, iname, message);
+            self->generation++;
+            self->batch_changed = true;
+        }
+        return false;
+    }
     if (self->iname && streq (self->iname, iname)) {
         // we received a message about ourselves, trigger recomputation
         zhashx_update (self->assets, iname, message);
+        self->generation++;
         zlistx_t *list = topologyresolver_to_list (self);
         if (! zlistx_size (list)) {
             // Can't resolve topology any more
@@ -267,10 +290,11 @@ topologyresolver_asset (topologyresolver_t *self, fty_proto_t *message)
     if (self->state == DISCOVERING) {
         // discovering - every asset (except me) is a possible parent
         zhashx_update (self->assets, iname, message);
+        self->generation++;
         zlistx_t *list = topologyresolver_to_list (self);
         if (zlistx_size (list)) {
             self->state = UPTODATE;
-            s_purge_message_cache (self);
+            s_purge_message_cache (self, list);
             zlistx_destroy (&list);
             return true;
         }
@@ -282,6 +306,7 @@ topologyresolver_asset (topologyresolver_t *self, fty_proto_t *message)
         if (iname_msg) {
             // we received a message about asset in our topology, trigger recomputation
             zhashx_update (self->assets, iname, message);
+        self->generation++;
             zlistx_t *list = topologyresolver_to_list (self);
             if (! zlistx_size (list)) {
                 // Can't resolv topology any more
@@ -297,6 +322,335 @@ topologyresolver_asset (topologyresolver_t *self, fty_proto_t *message)
     return false;
 }
 
+//  --------------------------------------------------------------------------
+//  Return true if message published on ASSETS stream with given subject
+//  (type.subtype@iname) may change the topology and is worth decoding.
+//  Rack controllers always are, as one of them might be me.
+bool
+topologyresolver_wants (topologyresolver_t *self, const char *subject)
+{
+    if (! self || ! subject) return false;
+    const char *at = strchr (subject, '@');
+    if (! at)
+        // unknown subject format, let the decoded message decide
+        return true;
+    const char *dot = (const char *) memchr (subject, '.', at - subject);
+    if (dot && (at - dot - 1) == (int) strlen ("rackcontroller")
+            && strncmp (dot + 1, "rackcontroller", at - dot - 1) == 0)
+        return true;
+
+    const char *iname = at + 1;
+    if (self->iname && streq (self->iname, iname))
+        return true;
+    if (zhashx_lookup (self->assets, iname))
+        return true;
+    // my parents belong to the topology even when they are not cached yet
+    return s_is_my_parent (self, iname);
+}
+
+//  --------------------------------------------------------------------------
+//  Resolve topology from cached assets after they changed
+//  return true if the topology is resolved
+static bool
+s_resolve (topologyresolver_t *self)
+{
+    zlistx_t *list = topologyresolver_to_list (self);
+    if (! zlistx_size (list)) {
+        // Can't resolve topology (yet)
+        self->state = DISCOVERING;
+        zlistx_destroy (&list);
+        return false;
+    }
+    if (self->state == DISCOVERING) {
+        self->state = UPTODATE;
+        s_purge_message_cache (self, list);
+    }
+    zlistx_destroy (&list);
+    return true;
+}
+
+//  --------------------------------------------------------------------------
+//  Start a batch of assets. Until topologyresolver_commit, assets are only
+//  cached and topologyresolver_asset returns false.
+void
+topologyresolver_begin (topologyresolver_t *self)
+{
+    if (! self || self->batch) return;
+    self->batch = true;
+    self->batch_changed = false;
+}
+
+//  --------------------------------------------------------------------------
+//  Finish a batch of assets and resolve the topology once for all of them.
+//  Return true if the batch changed the cache and the topology is resolved,
+//  as topologyresolver_asset does for a single asset.
+bool
+topologyresolver_commit (topologyresolver_t *self)
+{
+    if (! self || ! self->batch) return false;
+    self->batch = false;
+    if (! self->batch_changed) return false;
+    return s_resolve (self);
+}
+
+//  --------------------------------------------------------------------------
+//  Return true if ASSET AGENT was asked for the asset already
+static bool
+s_requested (topologyresolver_t *self, const char *iname)
+{
+    for (request_t *request = (request_t *) zhashx_first (self->requests);
+            request; request = (request_t *) zhashx_next (self->requests))
+        if (zlistx_find (request->inames, (void *) iname))
+            return true;
+    return false;
+}
+
+//  Send one ASSET_DETAIL request: GET/uuid/iname/iname/...
+static void
+s_request_send (topologyresolver_t *self, zlistx_t **inames_p)
+{
+    zlistx_t *inames = *inames_p;
+    *inames_p = NULL;
+    zuuid_t *uuid = zuuid_new ();
+    zmsg_t *msg = zmsg_new ();
+    zmsg_addstr (msg, "GET");
+    zmsg_addstr (msg, zuuid_str_canonical (uuid));
+    for (const char *iname = (const char *) zlistx_first (inames);
+            iname; iname = (const char *) zlistx_next (inames))
+        zmsg_addstr (msg, iname);
+    log_debug ("ask ASSET AGENT for ASSET_DETAIL, RC = %s, first iname = %s, %zu assets",
+            self->iname, (const char *) zlistx_first (inames), zlistx_size (inames));
+    int rv = mlm_client_sendto (self->client, FTY_ASSET_AGENT, "ASSET_DETAIL", NULL, 0, &msg);
+    if (rv != -1) {
+        request_t *request = (request_t *) zmalloc (sizeof (request_t));
+        request->inames = inames;
+        inames = NULL;
+        request->expires = fty_info_clock_mono (self->clock) + self->request_timeout;
+        zhashx_insert (self->requests, zuuid_str_canonical (uuid), request);
+    }
+    zmsg_destroy (&msg);
+    zlistx_destroy (&inames);
+    zuuid_destroy (&uuid);
+}
+
+//  --------------------------------------------------------------------------
+//  Ask ASSET AGENT for assets missing in the topology which are not asked for
+//  already. All of them go in one request, or in one request per asset if
+//  the agent does not support it; either way no request waits for another.
+static void
+s_request_details (topologyresolver_t *self, zlistx_t *missing)
+{
+    if (! self->client || ! mlm_client_connected (self->client))
+        return;
+    zlistx_t *inames = zlistx_new ();
+    zlistx_set_destructor (inames, (void (*)(void**))zstr_free);
+    zlistx_set_duplicator (inames, (void* (*)(const void*))strdup);
+    zlistx_set_comparator (inames, (int (*)(const void *,const void *))strcmp);
+    for (const char *iname = (const char *) zlistx_first (missing);
+            iname; iname = (const char *) zlistx_next (missing))
+        if (! s_requested (self, iname))
+            zlistx_add_end (inames, (void *) iname);
+
+    if (self->batch_details || zlistx_size (inames) <= 1) {
+        if (zlistx_size (inames) > 0)
+            s_request_send (self, &inames);
+    }
+    else
+        for (const char *iname = (const char *) zlistx_first (inames);
+                iname; iname = (const char *) zlistx_next (inames)) {
+            zlistx_t *single = zlistx_new ();
+            zlistx_set_destructor (single, (void (*)(void**))zstr_free);
+            zlistx_set_duplicator (single, (void* (*)(const void*))strdup);
+            zlistx_set_comparator (single, (int (*)(const void *,const void *))strcmp);
+            zlistx_add_end (single, (void *) iname);
+            s_request_send (self, &single);
+        }
+    zlistx_destroy (&inames);
+}
+
+//  --------------------------------------------------------------------------
+//  Process ASSET_DETAIL reply delivered to the shared client, takes ownership
+//  of the message. Replies are matched to requests by uuid, in any order.
+//  Reply to a request for many assets carries one frame per asset, in order
+//  they were asked for, empty if the asset is unknown. An agent answering
+//  just the first asset does not support batches, the rest is then asked for
+//  one by one. Return true if the reply resolved the topology.
+bool
+topologyresolver_reply (topologyresolver_t *self, zmsg_t **reply_p)
+{
+    assert (reply_p);
+    zmsg_t *reply = *reply_p;
+    *reply_p = NULL;
+    if (! self || ! reply) {
+        zmsg_destroy (&reply);
+        return false;
+    }
+    char *uuid = zmsg_popstr (reply);
+    request_t *request = uuid ? (request_t *) zhashx_lookup (self->requests, uuid) : NULL;
+    if (! request) {
+        // expired or not ours
+        log_debug ("unexpected ASSET_DETAIL reply %s, ignoring", uuid ? uuid : "");
+        zstr_free (&uuid);
+        zmsg_destroy (&reply);
+        return false;
+    }
+    zlistx_t *inames = request->inames;
+    request->inames = NULL;
+    zhashx_delete (self->requests, uuid);
+    zstr_free (&uuid);
+
+    size_t count = zlistx_size (inames);
+    bool fallback = false;
+    if (count > 1 && zmsg_size (reply) != count) {
+        log_info ("ASSET AGENT does not support ASSET_DETAIL for many assets, asking one by one");
+        self->batch_details = false;
+        fallback = true;
+    }
+    bool changed = false;
+    const char *iname = (const char *) zlistx_first (inames);
+    for (; iname; iname = (const char *) zlistx_next (inames)) {
+        zmsg_t *asset;
+        if (count == 1) {
+            asset = reply;
+            reply = NULL;
+        }
+        else {
+            zframe_t *frame = zmsg_pop (reply);
+            if (! frame)
+                break;
+            asset = zmsg_new ();
+            zmsg_append (asset, &frame);
+        }
+        fty_proto_t *msg = fty_proto_is (asset) ? fty_proto_decode (&asset) : NULL;
+        zmsg_destroy (&asset);
+        if (msg) {
+            zhashx_update (self->assets, iname, msg);
+            self->generation++;
+            changed = true;
+            fty_proto_destroy (&msg);
+        }
+        else
+            // unknown parent, topology is not complete
+            log_debug ("ASSET AGENT does not know %s", iname);
+    }
+    if (fallback) {
+        // ask for the rest one by one, they need not be missing when
+        // the request was a refresh
+        zlistx_t *rest = zlistx_new ();
+        for (; iname; iname = (const char *) zlistx_next (inames))
+            zlistx_add_end (rest, (void *) iname);
+        s_request_details (self, rest);
+        zlistx_destroy (&rest);
+    }
+    zlistx_destroy (&inames);
+    zmsg_destroy (&reply);
+
+    bool resolved = false;
+    if (changed)
+        resolved = s_resolve (self);
+    return resolved;
+}
+
+//  --------------------------------------------------------------------------
+//  Ask ASSET AGENT again for all assets of the resolved topology. Their
+//  updates missed on ASSETS stream are recovered when the reply arrives,
+//  topologyresolver_reply resolves the topology again then.
+void
+topologyresolver_refresh (topologyresolver_t *self)
+{
+    if (! self) return;
+    zlistx_t *inames = topologyresolver_inames (self);
+    s_request_details (self, inames);
+    zlistx_destroy (&inames);
+}
+
+//  --------------------------------------------------------------------------
+//  Return msec until the first pending ASSET_DETAIL request expires, -1 if
+//  there is none
+int
+topologyresolver_timeout (topologyresolver_t *self)
+{
+    if (! self || zhashx_size (self->requests) == 0)
+        return -1;
+    int64_t expires = INT64_MAX;
+    for (request_t *request = (request_t *) zhashx_first (self->requests);
+            request; request = (request_t *) zhashx_next (self->requests))
+        if (request->expires < expires)
+            expires = request->expires;
+    int64_t timeout = expires - fty_info_clock_mono (self->clock);
+    return timeout > 0 ? (int) timeout : 0;
+}
+
+//  --------------------------------------------------------------------------
+//  Give up ASSET_DETAIL requests without reply in time and ask again for
+//  assets still missing. Late replies to them are ignored.
+void
+topologyresolver_expire (topologyresolver_t *self)
+{
+    if (! self || zhashx_size (self->requests) == 0)
+        return;
+    int64_t now = fty_info_clock_mono (self->clock);
+    zlistx_t *uuids = zhashx_keys (self->requests);
+    bool expired = false;
+    for (const char *uuid = (const char *) zlistx_first (uuids);
+            uuid; uuid = (const char *) zlistx_next (uuids)) {
+        request_t *request = (request_t *) zhashx_lookup (self->requests, uuid);
+        if (request->expires <= now) {
+            log_warning ("no ASSET_DETAIL reply for %s in %d ms",
+                    (const char *) zlistx_first (request->inames), self->request_timeout);
+            if (zlistx_size (request->inames) > 1) {
+                // agent may drop requests it does not understand
+                log_info ("no reply for many assets, asking ASSET AGENT one by one");
+                self->batch_details = false;
+            }
+            zhashx_delete (self->requests, uuid);
+            expired = true;
+        }
+    }
+    zlistx_destroy (&uuids);
+    if (expired) {
+        zlistx_t *list = topologyresolver_to_list (self);
+        zlistx_destroy (&list);
+    }
+}
+
+//  --------------------------------------------------------------------------
+//  Return zlist of inames the known topology consists of, asset first.
+//  Unlike topologyresolver_to_list it never asks ASSET AGENT, empty list
+//  is returned while the topology is not resolved.
+zlistx_t *
+topologyresolver_inames (topologyresolver_t *self)
+{
+    zlistx_t *list = zlistx_new();
+    zlistx_set_destructor (list, (void (*)(void**))zstr_free);
+    zlistx_set_duplicator (list, (void* (*)(const void*))strdup);
+
+    if (!self || !self->iname || self->state != UPTODATE) return list;
+    fty_proto_t *msg = (fty_proto_t *) zhashx_lookup (self->assets, self->iname);
+    if (!msg)
+        return list;
+
+    zlistx_add_end (list, (void *) self->iname);
+    char buffer[16]; // strlen ("parent_name.123") + 1
+    for (int i=1; i<100; i++) {
+        snprintf (buffer, 16, "parent_name.%i", i);
+        const char *parent = fty_proto_aux_string (msg, buffer, NULL);
+        if (! parent) break;
+        zlistx_add_end (list, (void *) parent);
+    }
+    return list;
+}
+
+//  --------------------------------------------------------------------------
+//  Return number of changes of the cached assets so far. Anything derived
+//  from the resolver is up to date while the generation stays the same.
+uint64_t
+topologyresolver_generation (topologyresolver_t *self)
+{
+    if (! self) return 0;
+    return self->generation;
+}
+
 //  --------------------------------------------------------------------------
 // Return URI of asset for this topologyresolver
 char *
@@ -386,6 +740,9 @@ topologyresolver_to_string (topologyresolver_t *self, const char *separator)
 
     if (! zlistx_size (parents)) {
         zlistx_destroy (&parents);
+        // missing parents are being fetched, last known topology still holds
+        if (self && self->topology && zhashx_size (self->requests) > 0)
+            return strdup (self->topology);
         return NULL;
     }
 
@@ -431,52 +788,69 @@ topologyresolver_to_list (topologyresolver_t *self)
         return list;
 
     char buffer[16]; // strlen ("parent_name.123") + 1
+    zlistx_t *missing = zlistx_new ();
 
     for (int i=1; i<100; i++) {
         snprintf (buffer, 16, "parent_name.%i", i);
         const char *parent = fty_proto_aux_string (msg, buffer, NULL);
         if (! parent) break;
         if (! zhashx_lookup (self->assets, parent)) {
-            // ask ASSET_AGENT for ASSET_DETAIL
-            if (mlm_client_connected (self->client)) {
-                zuuid_t *uuid = zuuid_new ();
-                log_debug ("ask ASSET AGENT for ASSET_DETAIL, RC = %s, iname = %s", self->iname, parent);
-                mlm_client_sendtox (self->client, FTY_ASSET_AGENT, "ASSET_DETAIL",
-                        "GET", zuuid_str_canonical (uuid), parent, NULL);
-                zmsg_t *parent_msg = mlm_client_recv (self->client);
-                if (parent_msg) {
-                    char *rcv_uuid = zmsg_popstr (parent_msg);
-                    if (0 == strcmp (rcv_uuid, zuuid_str_canonical (uuid)) && fty_proto_is (parent_msg)) {
-                        fty_proto_t *parent_fmsg = fty_proto_decode (&parent_msg);
-                        zhashx_update (self->assets, parent, parent_fmsg);
-                        zlistx_add_start (list, (void *)parent);
-                    }
-                    else {
-                        // invalid zuuid or unknown parent, topology is not complete
-                        zlistx_purge (list);
-                        break;
-                    }
-                    zstr_free(&rcv_uuid);
-                }
-                else {
-                    // parent is unknown, topology is not complete
-                    zlistx_purge (list);
-                    break;
-                }
-                zuuid_destroy (&uuid);
-            }
-            else {
-                // parent is unknown, topology is not complete
-                zlistx_purge (list);
-                break;
-            }
+            // parent is unknown, topology is not complete
+            zlistx_add_end (missing, (void *) parent);
         } else {
             zlistx_add_start (list, (void *)parent);
         }
     }
+    if (zlistx_size (missing)) {
+        // ask ASSET_AGENT for ASSET_DETAIL of all missing parents,
+        // topologyresolver_reply resolves topology again when they arrive
+        s_request_details (self, missing);
+        zlistx_purge (list);
+    }
+    zlistx_destroy (&missing);
     return list;
 }
 
+//  --------------------------------------------------------------------------
+//  Fake ASSET AGENT of the selftest, serves one ASSET_DETAIL request from
+//  assets (iname -> fty_proto_t). Agent without batches answers only the
+//  first asset. Return number of assets asked for.
+static size_t
+s_test_agent_serve (mlm_client_t *agent, zhashx_t *assets, bool batches)
+{
+    zmsg_t *request = mlm_client_recv (agent);
+    assert (request);
+    assert (streq (mlm_client_subject (agent), "ASSET_DETAIL"));
+    char *command = zmsg_popstr (request);
+    assert (streq (command, "GET"));
+    zstr_free (&command);
+    char *uuid = zmsg_popstr (request);
+    size_t count = zmsg_size (request);
+
+    zmsg_t *reply = zmsg_new ();
+    zmsg_addstr (reply, uuid);
+    char *iname = zmsg_popstr (request);
+    while (iname) {
+        fty_proto_t *asset = (fty_proto_t *) zhashx_lookup (assets, iname);
+        if (asset) {
+            fty_proto_t *dup = fty_proto_dup (asset);
+            zmsg_t *encoded = fty_proto_encode (&dup);
+            zframe_t *frame = zmsg_pop (encoded);
+            zmsg_append (reply, &frame);
+            zmsg_destroy (&encoded);
+        }
+        else
+            zmsg_addmem (reply, NULL, 0);
+        zstr_free (&iname);
+        if (batches)
+            iname = zmsg_popstr (request);
+    }
+    mlm_client_sendto (agent, mlm_client_sender (agent), "ASSET_DETAIL", NULL, 1000, &reply);
+    zstr_free (&uuid);
+    zmsg_destroy (&request);
+    return count;
+}
+
 void
 topologyresolver_test (bool verbose)
 {
@@ -581,6 +955,274 @@ topologyresolver_test (bool verbose)
     assert (streq ("my nice grandparent->this is new father", res));
     free(res);
 
+    // subjects worth decoding: rack controllers, me and my parents
+    assert (topologyresolver_wants (resolver, "device.rackcontroller@rackcontroller-7"));
+    assert (topologyresolver_wants (resolver, "device.rackcontroller@me"));
+    assert (topologyresolver_wants (resolver, "rack.N_A@newparent"));
+    assert (topologyresolver_wants (resolver, "datacenter.N_A@grandparent"));
+    assert (!topologyresolver_wants (resolver, "device.ups@bogus"));
+    assert (!topologyresolver_wants (resolver, "device.ups@newparent-2"));
+    assert (!topologyresolver_wants (resolver, "device.rackcontrollers@bogus"));
+    assert (!topologyresolver_wants (resolver, "rack.N_A@parent"));
+    assert (topologyresolver_wants (resolver, "no subject format"));
+
+    zlistx_t *inames = topologyresolver_inames (resolver);
+    assert (zlistx_size (inames) == 3);
+    assert (streq ((char *) zlistx_first (inames), "me"));
+    assert (streq ((char *) zlistx_next (inames), "newparent"));
+    assert (streq ((char *) zlistx_next (inames), "grandparent"));
+    zlistx_destroy (&inames);
+
+    // batch: assets in any order, topology resolved once on commit
+    {
+        topologyresolver_t *batch = topologyresolver_new ("me");
+        topologyresolver_begin (batch);
+        assert (!topologyresolver_asset (batch, msg));     // grandparent
+        assert (!topologyresolver_asset (batch, msg1));    // bogus
+        assert (!topologyresolver_asset (batch, msg3));    // parent
+        assert (!topologyresolver_asset (batch, msg2));    // me
+        res = topologyresolver_to_string (batch, "->");
+        assert (streq ("my nice grandparent->this is father", res));
+        free (res);
+        assert (topologyresolver_commit (batch));
+        // bogus purged once resolved
+        assert (zhashx_size (batch->assets) == 3);
+        // empty batch changes nothing
+        topologyresolver_begin (batch);
+        assert (!topologyresolver_commit (batch));
+        // moved to a new parent, it comes in the same batch
+        topologyresolver_begin (batch);
+        assert (!topologyresolver_asset (batch, msg4));
+        assert (!topologyresolver_asset (batch, msg5));
+        assert (topologyresolver_commit (batch));
+        res = topologyresolver_to_string (batch, "->");
+        assert (streq ("my nice grandparent->this is new father", res));
+        free (res);
+        topologyresolver_destroy (&batch);
+    }
+
+    // REPUBLISH of many assets while discovering: one by one vs batch
+    {
+        const int count = 20000;
+        fty_proto_t **assets = (fty_proto_t **) zmalloc (count * sizeof (fty_proto_t *));
+        for (int i = 0; i < count; i++) {
+            assets[i] = fty_proto_new (FTY_PROTO_ASSET);
+            fty_proto_set_name (assets[i], "asset-%d", i);
+            fty_proto_set_operation (assets[i], FTY_PROTO_ASSET_OP_CREATE);
+        }
+        int64_t usecs[2];
+        for (int mode = 0; mode < 2; mode++) {
+            topologyresolver_t *republish = topologyresolver_new ("me");
+            topologyresolver_asset (republish, msg4);
+            int64_t start = zclock_usecs ();
+            if (mode == 1)
+                topologyresolver_begin (republish);
+            for (int i = 0; i < count; i++)
+                topologyresolver_asset (republish, assets[i]);
+            topologyresolver_asset (republish, msg5);
+            topologyresolver_asset (republish, msg);
+            bool resolved = mode == 1 ? topologyresolver_commit (republish) : true;
+            usecs[mode] = zclock_usecs () - start;
+            assert (resolved);
+            zlistx_t *list = topologyresolver_to_list (republish);
+            assert (zlistx_size (list) == 2);
+            zlistx_destroy (&list);
+            topologyresolver_destroy (&republish);
+        }
+        if (verbose)
+            printf ("\n   %d assets one by one: %" PRIi64 " us, batch: %" PRIi64 " us\n",
+                    count, usecs[0], usecs[1]);
+        for (int i = 0; i < count; i++)
+            fty_proto_destroy (&assets[i]);
+        free (assets);
+    }
+
+    // missing parents asked for in one request, replies matched by uuid
+    {
+        static const char *endpoint = "inproc://topologyresolver-test";
+        zactor_t *server = zactor_new (mlm_server, (void *) "Malamute");
+        zstr_sendx (server, "BIND", endpoint, NULL);
+        mlm_client_t *client = mlm_client_new ();
+        mlm_client_connect (client, endpoint, 1000, "topologyresolver-test");
+        mlm_client_t *agent = mlm_client_new ();
+        mlm_client_connect (agent, endpoint, 1000, FTY_ASSET_AGENT);
+        zhashx_t *assets = zhashx_new ();
+        zhashx_insert (assets, "parent", msg3);
+        zhashx_insert (assets, "grandparent", msg);
+        zhashx_insert (assets, "newparent", msg5);
+
+        // agent supporting batches resolves the topology in one round trip
+        topologyresolver_t *async = topologyresolver_new ("me");
+        topologyresolver_set_client (async, client);
+        assert (topologyresolver_timeout (async) == -1);
+        assert (!topologyresolver_asset (async, msg2));
+        assert (topologyresolver_timeout (async) >= 0);
+        assert (s_test_agent_serve (agent, assets, true) == 2);
+        zmsg_t *reply = mlm_client_recv (client);
+        assert (topologyresolver_reply (async, &reply));
+        assert (topologyresolver_timeout (async) == -1);
+        res = topologyresolver_to_string (async, "->");
+        assert (streq ("my nice grandparent->this is father", res));
+        free (res);
+
+        // moved to a new parent, old location holds until it is fetched
+        assert (!topologyresolver_asset (async, msg4));
+        res = topologyresolver_to_string (async, "->");
+        assert (streq ("my nice grandparent->this is father", res));
+        free (res);
+        assert (s_test_agent_serve (agent, assets, true) == 1);
+        reply = mlm_client_recv (client);
+        assert (topologyresolver_reply (async, &reply));
+        res = topologyresolver_to_string (async, "->");
+        assert (streq ("my nice grandparent->this is new father", res));
+        free (res);
+
+        // refresh recovers an update of grandparent missed on the stream
+        fty_proto_t *renamed = fty_proto_dup (msg);
+        fty_proto_ext_insert (renamed, "name", "%s", "renamed grandparent");
+        zhashx_update (assets, "grandparent", renamed);
+        zhashx_insert (assets, "me", msg4);
+        topologyresolver_refresh (async);
+        assert (s_test_agent_serve (agent, assets, true) == 3);
+        reply = mlm_client_recv (client);
+        assert (topologyresolver_reply (async, &reply));
+        res = topologyresolver_to_string (async, "->");
+        assert (streq ("renamed grandparent->this is new father", res));
+        free (res);
+        zhashx_update (assets, "grandparent", msg);
+        zhashx_delete (assets, "me");
+        fty_proto_destroy (&renamed);
+        topologyresolver_destroy (&async);
+
+        // agent without batches answers the first asset, the rest is
+        // asked for one by one from then on
+        async = topologyresolver_new ("me");
+        topologyresolver_set_client (async, client);
+        assert (!topologyresolver_asset (async, msg2));
+        assert (s_test_agent_serve (agent, assets, false) == 2);
+        reply = mlm_client_recv (client);
+        assert (!topologyresolver_reply (async, &reply));
+        assert (s_test_agent_serve (agent, assets, false) == 1);
+        reply = mlm_client_recv (client);
+        assert (topologyresolver_reply (async, &reply));
+        topologyresolver_destroy (&async);
+
+        // request without reply expires, it is asked for one by one again
+        // and the late reply is ignored
+        fty_info_clock_t *clock = fty_info_clock_new (true);
+        async = topologyresolver_new ("me");
+        topologyresolver_set_client (async, client);
+        topologyresolver_set_clock (async, clock);
+        topologyresolver_set_timeout (async, 100);
+        assert (!topologyresolver_asset (async, msg2));
+        zmsg_t *request = mlm_client_recv (agent);
+        char *command = zmsg_popstr (request);
+        char *expired = zmsg_popstr (request);
+        zstr_free (&command);
+        zmsg_destroy (&request);
+        assert (topologyresolver_timeout (async) == 100);
+        fty_info_clock_advance (clock, 150);
+        assert (topologyresolver_timeout (async) == 0);
+        topologyresolver_expire (async);
+        // location is unknown until the replies arrive
+        res = topologyresolver_to_string (async, "->");
+        assert (NULL == res);
+        uint64_t generation = topologyresolver_generation (async);
+        assert (s_test_agent_serve (agent, assets, true) == 1);
+        assert (s_test_agent_serve (agent, assets, true) == 1);
+        reply = mlm_client_recv (client);
+        assert (!topologyresolver_reply (async, &reply));
+        reply = mlm_client_recv (client);
+        assert (topologyresolver_reply (async, &reply));
+        assert (topologyresolver_generation (async) == generation + 2);
+        fty_proto_t *late = fty_proto_dup (msg3);
+        reply = fty_proto_encode (&late);
+        zmsg_pushstr (reply, expired);
+        mlm_client_sendto (agent, "topologyresolver-test", "ASSET_DETAIL", NULL, 1000, &reply);
+        reply = mlm_client_recv (client);
+        assert (!topologyresolver_reply (async, &reply));
+        assert (topologyresolver_generation (async) == generation + 2);
+        zstr_free (&expired);
+        topologyresolver_destroy (&async);
+        fty_info_clock_destroy (&clock);
+
+        zhashx_destroy (&assets);
+        mlm_client_destroy (&agent);
+        mlm_client_destroy (&client);
+        zactor_destroy (&server);
+    }
+
+    // round trips to resolve DC > room > row > rack > RC
+    {
+        static const char *endpoint = "inproc://topologyresolver-bench";
+        zactor_t *server = zactor_new (mlm_server, (void *) "Malamute");
+        zstr_sendx (server, "BIND", endpoint, NULL);
+        mlm_client_t *client = mlm_client_new ();
+        mlm_client_connect (client, endpoint, 1000, "topologyresolver-bench");
+        mlm_client_t *agent = mlm_client_new ();
+        mlm_client_connect (agent, endpoint, 1000, FTY_ASSET_AGENT);
+
+        const char *levels[] = {"rack-1", "row-1", "room-1", "datacenter-1"};
+        const int depth = 4;
+        zhashx_t *assets = zhashx_new ();
+        zhashx_set_destructor (assets, (czmq_destructor *) fty_proto_destroy);
+        for (int i = 0; i < depth; i++) {
+            fty_proto_t *level = fty_proto_new (FTY_PROTO_ASSET);
+            fty_proto_set_name (level, "%s", levels[i]);
+            fty_proto_set_operation (level, FTY_PROTO_ASSET_OP_CREATE);
+            for (int j = i + 1; j < depth; j++)
+                fty_proto_aux_insert (level, ("parent_name." + std::to_string (j - i)).c_str (), "%s", levels[j]);
+            zhashx_insert (assets, levels[i], level);
+        }
+        fty_proto_t *rc = fty_proto_new (FTY_PROTO_ASSET);
+        fty_proto_set_name (rc, "rackcontroller-1");
+        fty_proto_set_operation (rc, FTY_PROTO_ASSET_OP_CREATE);
+        for (int i = 0; i < depth; i++)
+            fty_proto_aux_insert (rc, ("parent_name." + std::to_string (i + 1)).c_str (), "%s", levels[i]);
+
+        int requests[2], trips[2];
+        int64_t usecs[2];
+        for (int batches = 1; batches >= 0; batches--) {
+            topologyresolver_t *deep = topologyresolver_new ("rackcontroller-1");
+            topologyresolver_set_client (deep, client);
+            int64_t start = zclock_usecs ();
+            topologyresolver_asset (deep, rc);
+            requests[batches] = 0;
+            trips[batches] = 0;
+            bool resolved = false;
+            while (!resolved) {
+                // serve everything asked for so far, that is one round trip
+                int pending = (int) zhashx_size (deep->requests);
+                assert (pending > 0);
+                trips[batches]++;
+                for (int i = 0; i < pending; i++) {
+                    s_test_agent_serve (agent, assets, batches);
+                    requests[batches]++;
+                    zmsg_t *reply = mlm_client_recv (client);
+                    resolved = topologyresolver_reply (deep, &reply);
+                }
+            }
+            usecs[batches] = zclock_usecs () - start;
+            zlistx_t *list = topologyresolver_to_list (deep);
+            assert (zlistx_size (list) == (size_t) depth);
+            zlistx_destroy (&list);
+            topologyresolver_destroy (&deep);
+        }
+        assert (requests[1] == 1 && trips[1] == 1);
+        // first asset in the batch, the rest one by one concurrently
+        assert (requests[0] == depth && trips[0] == 2);
+        if (verbose)
+            printf ("\n   depth %d: batch %d requests, %d round trips, %" PRIi64 " us;"
+                    " one by one %d requests, %d round trips, %" PRIi64 " us\n",
+                    depth, requests[1], trips[1], usecs[1], requests[0], trips[0], usecs[0]);
+
+        fty_proto_destroy (&rc);
+        zhashx_destroy (&assets);
+        mlm_client_destroy (&agent);
+        mlm_client_destroy (&client);
+        zactor_destroy (&server);
+    }
+
     fty_proto_destroy (&msg5);
     fty_proto_destroy (&msg4);
     fty_proto_destroy (&msg3);
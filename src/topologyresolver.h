@@ -35,9 +35,37 @@ FTY_INFO_PRIVATE topologyresolver_t *
 FTY_INFO_PRIVATE void
     topologyresolver_destroy (topologyresolver_t **self_p);
 
-//  Set endpoint for Malamute client
+//  Set shared Malamute client used to ask for missing assets
 FTY_INFO_PRIVATE void
-    topologyresolver_set_endpoint (topologyresolver_t *self, const char *endpoint);
+    topologyresolver_set_client (topologyresolver_t *self, mlm_client_t *client);
+
+//  Process ASSET_DETAIL reply delivered to the shared client. Return true
+//  if the topology got resolved
+FTY_INFO_PRIVATE bool
+    topologyresolver_reply (topologyresolver_t *self, zmsg_t **reply_p);
+
+//  Set msec to wait for ASSET_DETAIL reply, 5000 by default
+FTY_INFO_PRIVATE void
+    topologyresolver_set_timeout (topologyresolver_t *self, int timeout);
+
+//  Set clock ASSET_DETAIL requests expire on, system clock by default. It is
+//  not owned and must outlive the resolver.
+FTY_INFO_PRIVATE void
+    topologyresolver_set_clock (topologyresolver_t *self, fty_info_clock_t *clock);
+
+//  Ask ASSET AGENT again for all assets of the resolved topology, to recover
+//  their updates missed on ASSETS stream
+FTY_INFO_PRIVATE void
+    topologyresolver_refresh (topologyresolver_t *self);
+
+//  Return msec until the first pending ASSET_DETAIL request expires, -1 if
+//  there is none
+FTY_INFO_PRIVATE int
+    topologyresolver_timeout (topologyresolver_t *self);
+
+//  Give up expired ASSET_DETAIL requests and ask for missing assets again
+FTY_INFO_PRIVATE void
+    topologyresolver_expire (topologyresolver_t *self);
 
 //  get RC internal name
 FTY_INFO_PRIVATE char *
@@ -51,6 +79,24 @@ FTY_INFO_PRIVATE char *
 FTY_INFO_PRIVATE bool
     topologyresolver_asset (topologyresolver_t *self, fty_proto_t *message);
 
+//  Start a batch of assets, they are only cached until commit
+FTY_INFO_PRIVATE void
+    topologyresolver_begin (topologyresolver_t *self);
+
+//  Resolve topology once for assets given since begin. Return true if
+//  the batch changed the cache and the topology is resolved
+FTY_INFO_PRIVATE bool
+    topologyresolver_commit (topologyresolver_t *self);
+
+//  Return true if ASSETS stream message with given subject (type.subtype@iname)
+//  may change the topology
+FTY_INFO_PRIVATE bool
+    topologyresolver_wants (topologyresolver_t *self, const char *subject);
+
+//  Return number of changes of the cached assets so far
+FTY_INFO_PRIVATE uint64_t
+    topologyresolver_generation (topologyresolver_t *self);
+
 //  Return URI of the asset's parent
 FTY_INFO_PRIVATE char *
     topologyresolver_to_parent_uri (topologyresolver_t *self);
@@ -76,6 +122,11 @@ FTY_INFO_PRIVATE char *
 FTY_INFO_PRIVATE zlistx_t *
     topologyresolver_to_list (topologyresolver_t *self);
 
+//  Return zlist of inames of the resolved topology starting with asset,
+//  without asking ASSET AGENT. Empty list is returned if not resolved yet
+FTY_INFO_PRIVATE zlistx_t *
+    topologyresolver_inames (topologyresolver_t *self);
+
 // Selftest for this class
 FTY_INFO_PRIVATE void
     topologyresolver_test (bool verbose);